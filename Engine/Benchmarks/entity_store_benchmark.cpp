@@ -0,0 +1,216 @@
+#include "entity_store.h"
+#include "matrix_kernels.h"
+#include <chrono>
+#include <random>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+//Iteration cost of the EntityStore against the layout it replaced, a vector of individually
+//allocated entities, CPU only:
+//  - flags: the reads of the culling and grouping loops (visibility, model, bounds index)
+//  - transforms: view projection times every world matrix
+//  - churn: removing and adding back a quarter of the entities through their handles
+//The legacy entities are allocated between unrelated blocks, as they end up in a heap that
+//has been in use for a while. Cache misses come from perf events on Linux, when allowed.
+//Usage: entity_store_benchmark [--entities N] [--iterations N]
+
+typedef std::chrono::steady_clock Clock;
+
+struct LegacyEntity
+{
+    glm::mat4 worldMatrix;
+    u32 modelIdx = 0;
+    u32 firstBoundsIdx = 0;
+    bool isVisible = true;
+};
+
+struct CacheMissCounter
+{
+    int fd = -1;
+};
+
+static void StartCacheMisses(CacheMissCounter& counter)
+{
+#ifdef __linux__
+    if (counter.fd < 0)
+    {
+        perf_event_attr attributes = {};
+        attributes.type = PERF_TYPE_HARDWARE;
+        attributes.size = sizeof(attributes);
+        attributes.config = PERF_COUNT_HW_CACHE_MISSES;
+        attributes.disabled = 1;
+        attributes.exclude_kernel = 1;
+        attributes.exclude_hv = 1;
+        counter.fd = (int)syscall(__NR_perf_event_open, &attributes, 0, -1, -1, 0);
+    }
+    if (counter.fd >= 0)
+    {
+        ioctl(counter.fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(counter.fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+#endif
+}
+
+//Negative when the counter is not available
+static i64 StopCacheMisses(CacheMissCounter& counter)
+{
+#ifdef __linux__
+    if (counter.fd >= 0)
+    {
+        ioctl(counter.fd, PERF_EVENT_IOC_DISABLE, 0);
+        i64 misses = 0;
+        if (read(counter.fd, &misses, sizeof(misses)) == sizeof(misses))
+            return misses;
+    }
+#endif
+    return -1;
+}
+
+struct Measurement
+{
+    f64 milliseconds = 0.0;
+    i64 cacheMisses = -1;
+};
+
+template <typename Function>
+static Measurement Measure(CacheMissCounter& counter, u32 iterations, Function function)
+{
+    Measurement measurement;
+    StartCacheMisses(counter);
+    Clock::time_point start = Clock::now();
+    for (u32 iteration = 0; iteration < iterations; ++iteration)
+        function();
+    measurement.milliseconds = std::chrono::duration<f64, std::milli>(Clock::now() - start).count() / iterations;
+    i64 misses = StopCacheMisses(counter);
+    measurement.cacheMisses = misses < 0 ? -1 : misses / iterations;
+    return measurement;
+}
+
+static void PrintMeasurement(const char* name, const Measurement& legacy, const Measurement& store)
+{
+    printf("%-12s %12.3f %12.3f %7.2fx", name, legacy.milliseconds, store.milliseconds, legacy.milliseconds / store.milliseconds);
+    if (legacy.cacheMisses >= 0 && store.cacheMisses >= 0)
+        printf(" %14lld %14lld\n", (long long)legacy.cacheMisses, (long long)store.cacheMisses);
+    else
+        printf(" %14s %14s\n", "n/a", "n/a");
+}
+
+int main(int argc, char** argv)
+{
+    u32 entityCount = 100000;
+    u32 iterations = 20;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "--entities") == 0 && i + 1 < argc)
+            entityCount = (u32)atoi(argv[++i]);
+        else if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc)
+            iterations = (u32)atoi(argv[++i]);
+        else
+            fprintf(stderr, "Unknown argument %s\n", argv[i]);
+    }
+
+    std::mt19937 random(1234);
+    std::uniform_int_distribution<u32> fillerSize(16, 512);
+
+    std::vector<LegacyEntity*> legacyEntities(entityCount);
+    std::vector<void*> fillers(entityCount);
+    EntityStore store;
+    std::vector<EntityHandle> handles(entityCount);
+    for (u32 i = 0; i < entityCount; ++i)
+    {
+        glm::mat4 world = glm::translate(glm::mat4(1.0f), glm::vec3((f32)(i % 100), 0.0f, (f32)(i / 100)));
+        legacyEntities[i] = new LegacyEntity();
+        legacyEntities[i]->worldMatrix = world;
+        legacyEntities[i]->modelIdx = i % 3;
+        legacyEntities[i]->firstBoundsIdx = i;
+        legacyEntities[i]->isVisible = i % 4 != 0;
+        fillers[i] = malloc(fillerSize(random));
+
+        handles[i] = AddEntity(store, world, i % 3);
+        u32 entityIdx = GetEntityIndex(store, handles[i]);
+        store.firstBoundsIndices[entityIdx] = i;
+        store.isVisible[entityIdx] = i % 4 != 0;
+    }
+
+    const glm::mat4 viewProjection = glm::perspective(glm::radians(45.0f), 4.0f / 3.0f, 0.1f, 100.0f) *
+        glm::lookAt(glm::vec3(0.0f, 5.0f, 10.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    std::vector<glm::mat4> MVPs(entityCount);
+    volatile u64 sink = 0;
+    CacheMissCounter counter;
+
+    printf("%u entities x %u iterations, %s matrix kernels, times in ms\n", entityCount, iterations, GetMatrixKernelsISA());
+    printf("%-12s %12s %12s %8s %14s %14s\n", "pass", "legacy", "store", "speedup", "legacy misses", "store misses");
+
+    //--Flags--
+    Measurement legacyFlags = Measure(counter, iterations, [&]
+    {
+        u64 sum = 0;
+        for (LegacyEntity* entity : legacyEntities)
+            if (entity->isVisible)
+                sum += entity->modelIdx + entity->firstBoundsIdx;
+        sink = sink + sum;
+    });
+    Measurement storeFlags = Measure(counter, iterations, [&]
+    {
+        u64 sum = 0;
+        for (u32 i = 0; i < store.count; ++i)
+            if (store.isVisible[i])
+                sum += store.modelIndices[i] + store.firstBoundsIndices[i];
+        sink = sink + sum;
+    });
+    PrintMeasurement("flags", legacyFlags, storeFlags);
+
+    //--Transforms--
+    Measurement legacyTransforms = Measure(counter, iterations, [&]
+    {
+        for (u32 i = 0; i < entityCount; ++i)
+            MVPs[i] = viewProjection * legacyEntities[i]->worldMatrix;
+    });
+    Measurement storeTransforms = Measure(counter, iterations, [&]
+    {
+        MultiplyMatrices(viewProjection, store.worldMatrices.data(), MVPs.data(), store.count);
+    });
+    PrintMeasurement("transforms", legacyTransforms, storeTransforms);
+
+    //--Churn--
+    //The legacy layout erases from the middle of the vector, the store swaps with the last
+    u32 churnCount = entityCount / 4;
+    std::vector<u32> churnIndices(churnCount);
+    for (u32 i = 0; i < churnCount; ++i)
+        churnIndices[i] = random() % entityCount;
+
+    Measurement legacyChurn = Measure(counter, 1, [&]
+    {
+        for (u32 i = 0; i < churnCount; ++i)
+        {
+            u32 entityIdx = churnIndices[i] % legacyEntities.size();
+            delete legacyEntities[entityIdx];
+            legacyEntities.erase(legacyEntities.begin() + entityIdx);
+        }
+        for (u32 i = 0; i < churnCount; ++i)
+            legacyEntities.push_back(new LegacyEntity());
+    });
+    Measurement storeChurn = Measure(counter, 1, [&]
+    {
+        for (u32 i = 0; i < churnCount; ++i)
+            RemoveEntity(store, handles[churnIndices[i]]);
+        for (u32 i = 0; i < churnCount; ++i)
+            AddEntity(store, glm::mat4(1.0f), 0);
+    });
+    PrintMeasurement("churn", legacyChurn, storeChurn);
+
+    for (LegacyEntity* entity : legacyEntities)
+        delete entity;
+    for (void* filler : fillers)
+        free(filler);
+    return 0;
+}
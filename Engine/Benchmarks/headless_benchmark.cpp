@@ -0,0 +1,171 @@
+#include "engine.h"
+#include <string.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+
+//Renders offscreen for a fixed number of frames and reports the frame times.
+//Same as "Engine --headless" but without linking glfw, so it runs on nodes without a window system.
+//  --frames <n>       Measured frames, default: the length of the camera path or 600
+//  --scene <file>     Scene description to render instead of the built-in scene
+//  --dt <seconds>     Fixed delta time of every frame, default 1/60
+//  --warmup <n>       Frames rendered before measuring, default 30
+//  --json <file>      Writes the percentiles of the run
+//  --baseline <file>  JSON of an earlier run, exits with 1 if a percentile regressed
+//  --threshold <f>    Relative growth allowed over the baseline, default 0.1
+//  --trace <file>     Saves the CPU trace of the run once it is over
+//  --stress <options> Adds a generated stress scene, e.g. instances=1000,lights=32,materials=16
+//  --sweep <parameter>=<v1,v2,...>
+//                     Runs once per value of instances, lights or materials on the stress scene
+//  --csv <file>       Writes the percentiles of every sweep run, one row per value
+
+static void InitHeadlessApp(App& app)
+{
+    app.displaySize = ivec2(WINDOW_WIDTH, WINDOW_HEIGHT);
+    app.isRunning = true;
+}
+
+static bool ParseSweep(const char* text, std::string& parameter, std::vector<u32>& values)
+{
+    const char* equals = strchr(text, '=');
+    if (!equals)
+        return false;
+    parameter.assign(text, equals);
+    if (parameter != "instances" && parameter != "lights" && parameter != "materials")
+        return false;
+
+    for (const char* value = equals + 1; *value;)
+    {
+        char* end = NULL;
+        long number = strtol(value, &end, 10);
+        if (end == value || number < 0 || (*end != ',' && *end != '\0'))
+            return false;
+        values.push_back((u32)number);
+        value = *end == ',' ? end + 1 : end;
+    }
+    return !values.empty();
+}
+
+//One benchmark per value of the swept parameter, each with an app and context of its own
+static int RunSweep(BenchmarkOptions options, const StressSceneOptions& stress, const std::string& parameter,
+    const std::vector<u32>& values, const char* csvPath)
+{
+    std::vector<BenchmarkSamples> runs(values.size());
+    for (u32 i = 0; i < values.size(); ++i)
+    {
+        StressSceneOptions runStress = stress;
+        if (parameter == "instances")
+            runStress.instanceCount = values[i];
+        else if (parameter == "lights")
+            runStress.pointLightCount = values[i];
+        else
+            runStress.materialCount = glm::max(values[i], 1u);
+        options.stress = &runStress;
+
+        ILOG("Sweep: %s = %u", parameter.c_str(), values[i]);
+        App app = {};
+        InitHeadlessApp(app);
+        if (RunBenchmark(&app, options, &runs[i]) != 0)
+            return -1;
+    }
+
+    ILOG("Sweep: %12s %12s %12s %12s", parameter.c_str(), "CPU p50", "Frame p50", "GPU p50");
+    for (u32 i = 0; i < values.size(); ++i)
+    {
+        ILOG("Sweep: %12u %12.3f %12.3f %12.3f", values[i], ComputePercentiles(runs[i].cpuMilliseconds).p50,
+            ComputePercentiles(runs[i].frameMilliseconds).p50, ComputePercentiles(runs[i].gpuFrameMilliseconds).p50);
+    }
+
+    if (csvPath)
+    {
+        if (!WriteScalingCsv(csvPath, parameter.c_str(), values, runs))
+            return -1;
+        ILOG("Sweep: results written to %s", csvPath);
+    }
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    App app = {};
+    InitHeadlessApp(app);
+
+    BenchmarkOptions options;
+    StressSceneOptions stress;
+    bool hasStress = false;
+    std::string sweepParameter;
+    std::vector<u32> sweepValues;
+    const char* csvPath = NULL;
+    const char* tracePath = NULL;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+            options.frames = (u32)atoi(argv[++i]);
+        else if (strcmp(argv[i], "--scene") == 0 && i + 1 < argc)
+            options.scenePath = argv[++i];
+        else if (strcmp(argv[i], "--dt") == 0 && i + 1 < argc)
+            options.fixedDeltaTime = (f32)atof(argv[++i]);
+        else if (strcmp(argv[i], "--warmup") == 0 && i + 1 < argc)
+            options.warmupFrames = (u32)atoi(argv[++i]);
+        else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc)
+            options.jsonPath = argv[++i];
+        else if (strcmp(argv[i], "--baseline") == 0 && i + 1 < argc)
+            options.baselinePath = argv[++i];
+        else if (strcmp(argv[i], "--threshold") == 0 && i + 1 < argc)
+            options.regressionThreshold = (f32)atof(argv[++i]);
+        else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc)
+            tracePath = argv[++i];
+        else if (strcmp(argv[i], "--stress") == 0 && i + 1 < argc)
+        {
+            if (!ParseStressSceneOptions(argv[++i], stress))
+                return -1;
+            hasStress = true;
+        }
+        else if (strcmp(argv[i], "--sweep") == 0 && i + 1 < argc)
+        {
+            if (!ParseSweep(argv[++i], sweepParameter, sweepValues))
+            {
+                ELOG("--sweep expects instances, lights or materials followed by =v1,v2,...");
+                return -1;
+            }
+        }
+        else if (strcmp(argv[i], "--csv") == 0 && i + 1 < argc)
+            csvPath = argv[++i];
+        else
+            ELOG("Unknown argument %s", argv[i]);
+    }
+
+    if (options.fixedDeltaTime <= 0.0f)
+    {
+        ELOG("--dt must be greater than 0");
+        return -1;
+    }
+
+    int result = 0;
+    if (!sweepValues.empty())
+    {
+        if (options.jsonPath || options.baselinePath)
+        {
+            ELOG("--json and --baseline compare single runs, sweeps write --csv");
+            return -1;
+        }
+        result = RunSweep(options, stress, sweepParameter, sweepValues, csvPath);
+    }
+    else
+    {
+        options.stress = hasStress ? &stress : NULL;
+        result = RunBenchmark(&app, options);
+    }
+    if (tracePath)
+    {
+        if (SaveChromeTrace(tracePath))
+        {
+            ILOG("CPU trace saved to %s", tracePath);
+        }
+        else
+        {
+            ELOG("Could not save the CPU trace to %s", tracePath);
+        }
+    }
+    return result;
+}
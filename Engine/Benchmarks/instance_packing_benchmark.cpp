@@ -0,0 +1,128 @@
+#include "instance_packing.h"
+#include "job_system.h"
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+//Cost of writing the instance data of N entities, CPU only:
+//  - serial: projection * view * world per entity with glm, as the packing used to do
+//  - hoisted: WriteInstances on one thread, shared view projection and SSE math
+//  - parallel: WriteInstances over INSTANCE_RANGE_SIZE ranges on the job system
+//Usage: instance_packing_benchmark [--entities N] [--iterations N] [--threads N]
+//Without --entities it runs 10k and 100k.
+
+typedef std::chrono::steady_clock Clock;
+
+static f64 MillisecondsSince(Clock::time_point start)
+{
+    return std::chrono::duration<f64, std::milli>(Clock::now() - start).count();
+}
+
+static void WriteInstancesSerial(InstanceData* instances, const glm::mat4* worldMatrices, const u32* entityIndices, u32 count,
+    const glm::mat4& projection, const glm::mat4& view, u32 materialIdx)
+{
+    for (u32 i = 0; i < count; ++i)
+    {
+        const glm::mat4& world = worldMatrices[entityIndices[i]];
+        const glm::mat4 worldRows = glm::transpose(world);
+        instances[i].worldRows[0] = worldRows[0];
+        instances[i].worldRows[1] = worldRows[1];
+        instances[i].worldRows[2] = worldRows[2];
+        instances[i].MVP = projection * view * world;
+        instances[i].materialIdx = materialIdx;
+    }
+}
+
+static void RunBenchmark(JobSystem& jobs, u32 entityCount, u32 iterations)
+{
+    std::vector<glm::mat4> worldMatrices(entityCount);
+    std::vector<u32> entityIndices(entityCount);
+    for (u32 i = 0; i < entityCount; ++i)
+    {
+        glm::mat4 world = glm::translate(glm::mat4(1.0f), glm::vec3((f32)(i % 100), 0.0f, (f32)(i / 100)));
+        world = glm::rotate(world, glm::radians((f32)(i % 360)), glm::vec3(0.0f, 1.0f, 0.0f));
+        worldMatrices[i] = world;
+        entityIndices[i] = i;
+    }
+
+    const glm::mat4 projection = glm::perspective(glm::radians(45.0f), 4.0f / 3.0f, 0.1f, 100.0f);
+    const glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 5.0f, 10.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    const glm::mat4 viewProjection = projection * view;
+    std::vector<InstanceData> reference(entityCount);
+    std::vector<InstanceData> instances(entityCount);
+
+    Clock::time_point start = Clock::now();
+    for (u32 iteration = 0; iteration < iterations; ++iteration)
+        WriteInstancesSerial(reference.data(), worldMatrices.data(), entityIndices.data(), entityCount, projection, view, 0);
+    f64 serialMs = MillisecondsSince(start) / iterations;
+
+    start = Clock::now();
+    for (u32 iteration = 0; iteration < iterations; ++iteration)
+        WriteInstances(instances.data(), worldMatrices.data(), entityIndices.data(), entityCount, viewProjection, 0);
+    f64 hoistedMs = MillisecondsSince(start) / iterations;
+
+    u32 rangeCount = (entityCount + INSTANCE_RANGE_SIZE - 1) / INSTANCE_RANGE_SIZE;
+    start = Clock::now();
+    for (u32 iteration = 0; iteration < iterations; ++iteration)
+    {
+        ParallelFor(jobs, rangeCount, 1, [&](u32 begin, u32 end)
+        {
+            for (u32 r = begin; r < end; ++r)
+            {
+                u32 first = r * INSTANCE_RANGE_SIZE;
+                u32 count = glm::min(entityCount - first, (u32)INSTANCE_RANGE_SIZE);
+                WriteInstances(&instances[first], worldMatrices.data(), &entityIndices[first], count, viewProjection, 0);
+            }
+        });
+    }
+    f64 parallelMs = MillisecondsSince(start) / iterations;
+
+    //glm also multiplies (projection * view) * world, so any difference is a bug
+    f32 maxError = 0.0f;
+    for (u32 i = 0; i < entityCount; ++i)
+        for (u32 c = 0; c < 4; ++c)
+            for (u32 r = 0; r < 4; ++r)
+                maxError = glm::max(maxError, glm::abs(instances[i].MVP[c][r] - reference[i].MVP[c][r]));
+
+    printf("%9u %12.3f %12.3f %7.2fx %12.3f %7.2fx %12g\n", entityCount, serialMs, hoistedMs, serialMs / hoistedMs,
+        parallelMs, serialMs / parallelMs, maxError);
+}
+
+int main(int argc, char** argv)
+{
+    u32 entityCount = 0;
+    u32 iterations = 20;
+    u32 threads = glm::max(std::thread::hardware_concurrency(), 1u);
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "--entities") == 0 && i + 1 < argc)
+            entityCount = (u32)atoi(argv[++i]);
+        else if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc)
+            iterations = (u32)atoi(argv[++i]);
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+            threads = glm::max((u32)atoi(argv[++i]), 1u);
+        else
+            fprintf(stderr, "Unknown argument %s\n", argv[i]);
+    }
+
+    //The calling thread is one of them
+    JobSystem jobs;
+    CreateJobSystem(jobs, threads - 1);
+
+    printf("%u threads, %u iterations, times in ms\n", threads, iterations);
+    printf("%9s %12s %12s %8s %12s %8s %12s\n", "entities", "serial", "hoisted", "speedup", "parallel", "speedup", "max error");
+    if (entityCount > 0)
+    {
+        RunBenchmark(jobs, entityCount, iterations);
+    }
+    else
+    {
+        RunBenchmark(jobs, 10000, iterations);
+        RunBenchmark(jobs, 100000, iterations);
+    }
+
+    DestroyJobSystem(jobs);
+    return 0;
+}
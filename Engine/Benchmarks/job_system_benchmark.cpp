@@ -0,0 +1,127 @@
+#include "job_system.h"
+#include <stb_image.h>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+//Scaling of the job system with its first two users, CPU only:
+//  - per entity MVP products, as a ParallelFor over the entities
+//  - the image decoding of asset import, one job per image, as in LoadTextures2D
+//Usage: job_system_benchmark [--entities N] [--iterations N] [--max-threads N] [--image file] [--images N]
+//Run it from the working directory so the default image is found.
+
+typedef std::chrono::steady_clock Clock;
+
+static f64 MillisecondsSince(Clock::time_point start)
+{
+    return std::chrono::duration<f64, std::milli>(Clock::now() - start).count();
+}
+
+static f64 RunTransformBenchmark(JobSystem& jobs, const std::vector<glm::mat4>& worlds, std::vector<glm::mat4>& MVPs, u32 iterations)
+{
+    const glm::mat4 viewProjection = glm::perspective(glm::radians(45.0f), 4.0f / 3.0f, 0.1f, 100.0f) *
+        glm::lookAt(glm::vec3(0.0f, 5.0f, 10.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+
+    Clock::time_point start = Clock::now();
+    for (u32 iteration = 0; iteration < iterations; ++iteration)
+    {
+        ParallelFor(jobs, (u32)worlds.size(), 256, [&](u32 begin, u32 end)
+        {
+            for (u32 i = begin; i < end; ++i)
+                MVPs[i] = viewProjection * worlds[i];
+        });
+    }
+    return MillisecondsSince(start) / iterations;
+}
+
+static f64 RunDecodeBenchmark(JobSystem& jobs, const std::vector<u8>& file, u32 imageCount)
+{
+    Clock::time_point start = Clock::now();
+    JobCounter counter;
+    for (u32 i = 0; i < imageCount; ++i)
+    {
+        RunJob(jobs, [&file]
+        {
+            int width, height, channels;
+            u8* pixels = stbi_load_from_memory(file.data(), (int)file.size(), &width, &height, &channels, 0);
+            stbi_image_free(pixels);
+        }, &counter);
+    }
+    WaitForCounter(jobs, counter);
+    return MillisecondsSince(start);
+}
+
+static bool ReadFile(const char* filepath, std::vector<u8>& data)
+{
+    FILE* file = fopen(filepath, "rb");
+    if (!file)
+        return false;
+
+    fseek(file, 0, SEEK_END);
+    data.resize(ftell(file));
+    fseek(file, 0, SEEK_SET);
+    bool success = fread(data.data(), 1, data.size(), file) == data.size();
+    fclose(file);
+    return success;
+}
+
+int main(int argc, char** argv)
+{
+    u32 entityCount = 100000;
+    u32 iterations = 20;
+    u32 maxThreads = 64;
+    u32 imageCount = 64;
+    const char* imagePath = "dice.png";
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "--entities") == 0 && i + 1 < argc)
+            entityCount = (u32)atoi(argv[++i]);
+        else if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc)
+            iterations = (u32)atoi(argv[++i]);
+        else if (strcmp(argv[i], "--max-threads") == 0 && i + 1 < argc)
+            maxThreads = (u32)atoi(argv[++i]);
+        else if (strcmp(argv[i], "--image") == 0 && i + 1 < argc)
+            imagePath = argv[++i];
+        else if (strcmp(argv[i], "--images") == 0 && i + 1 < argc)
+            imageCount = (u32)atoi(argv[++i]);
+        else
+            fprintf(stderr, "Unknown argument %s\n", argv[i]);
+    }
+
+    std::vector<glm::mat4> worlds(entityCount);
+    std::vector<glm::mat4> MVPs(entityCount);
+    for (u32 i = 0; i < entityCount; ++i)
+        worlds[i] = glm::translate(glm::mat4(1.0f), glm::vec3((f32)(i % 100), 0.0f, (f32)(i / 100)));
+
+    std::vector<u8> imageFile;
+    bool decode = imageCount > 0 && ReadFile(imagePath, imageFile);
+    if (!decode)
+        fprintf(stderr, "Could not read %s, skipping the decoding benchmark\n", imagePath);
+
+    printf("%u hardware threads, %u entities x %u iterations, %u decodes of %s\n",
+        std::thread::hardware_concurrency(), entityCount, iterations, decode ? imageCount : 0, imagePath);
+    printf("%8s %14s %8s %14s %8s\n", "threads", "transform ms", "speedup", "decode ms", "speedup");
+
+    f64 baseTransform = 0.0, baseDecode = 0.0;
+    for (u32 threads = 1; threads <= maxThreads; threads *= 2)
+    {
+        //The calling thread is one of them
+        JobSystem jobs;
+        CreateJobSystem(jobs, threads - 1);
+
+        f64 transformMs = RunTransformBenchmark(jobs, worlds, MVPs, iterations);
+        f64 decodeMs = decode ? RunDecodeBenchmark(jobs, imageFile, imageCount) : 0.0;
+        if (threads == 1)
+        {
+            baseTransform = transformMs;
+            baseDecode = decodeMs;
+        }
+
+        printf("%8u %14.3f %7.2fx %14.3f %7.2fx\n", threads, transformMs, baseTransform / transformMs,
+            decodeMs, decode ? baseDecode / decodeMs : 0.0);
+        DestroyJobSystem(jobs);
+    }
+    return 0;
+}
@@ -0,0 +1,94 @@
+#include "matrix_kernels.h"
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+//View projection times N world matrices, CPU only:
+//  - glm: one operator* per matrix, the path the kernels replace
+//  - arrays: MultiplyMatrices over glm::mat4 arrays
+//  - blocks: MultiplyMatrixBlocks over the AoSoA layout, kernel only
+//  - blocks + conversion: the same with PackMatrixBlocks and UnpackMatrixBlocks around it
+//Usage: matrix_kernels_benchmark [--matrices N] [--iterations N]
+//Build with ENGINE_ENABLE_AVX2 or ENGINE_NATIVE_ARCH for the AVX2 kernels.
+
+typedef std::chrono::steady_clock Clock;
+
+static f64 MillisecondsSince(Clock::time_point start)
+{
+    return std::chrono::duration<f64, std::milli>(Clock::now() - start).count();
+}
+
+static f32 MaxError(const std::vector<glm::mat4>& a, const std::vector<glm::mat4>& b)
+{
+    f32 maxError = 0.0f;
+    for (size_t i = 0; i < a.size(); ++i)
+        for (u32 c = 0; c < 4; ++c)
+            for (u32 r = 0; r < 4; ++r)
+                maxError = glm::max(maxError, glm::abs(a[i][c][r] - b[i][c][r]));
+    return maxError;
+}
+
+int main(int argc, char** argv)
+{
+    u32 matrixCount = 100000;
+    u32 iterations = 50;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "--matrices") == 0 && i + 1 < argc)
+            matrixCount = (u32)atoi(argv[++i]);
+        else if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc)
+            iterations = (u32)atoi(argv[++i]);
+        else
+            fprintf(stderr, "Unknown argument %s\n", argv[i]);
+    }
+
+    std::vector<glm::mat4> worlds(matrixCount);
+    for (u32 i = 0; i < matrixCount; ++i)
+    {
+        glm::mat4 world = glm::translate(glm::mat4(1.0f), glm::vec3((f32)(i % 100), (f32)(i % 7), (f32)(i / 100)));
+        world = glm::rotate(world, glm::radians((f32)(i % 360)), glm::vec3(0.0f, 1.0f, 0.0f));
+        worlds[i] = glm::scale(world, glm::vec3(1.0f + (f32)(i % 5)));
+    }
+    const glm::mat4 viewProjection = glm::perspective(glm::radians(45.0f), 4.0f / 3.0f, 0.1f, 100.0f) *
+        glm::lookAt(glm::vec3(0.0f, 5.0f, 10.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+
+    u32 blockCount = (matrixCount + MATRIX_BLOCK_WIDTH - 1) / MATRIX_BLOCK_WIDTH;
+    std::vector<MatrixBlock> worldBlocks(blockCount), resultBlocks(blockCount);
+    std::vector<glm::mat4> reference(matrixCount), results(matrixCount), blockResults(matrixCount);
+    PackMatrixBlocks(worlds.data(), matrixCount, worldBlocks.data());
+
+    Clock::time_point start = Clock::now();
+    for (u32 iteration = 0; iteration < iterations; ++iteration)
+        for (u32 i = 0; i < matrixCount; ++i)
+            reference[i] = viewProjection * worlds[i];
+    f64 glmMs = MillisecondsSince(start) / iterations;
+
+    start = Clock::now();
+    for (u32 iteration = 0; iteration < iterations; ++iteration)
+        MultiplyMatrices(viewProjection, worlds.data(), results.data(), matrixCount);
+    f64 arraysMs = MillisecondsSince(start) / iterations;
+
+    start = Clock::now();
+    for (u32 iteration = 0; iteration < iterations; ++iteration)
+        MultiplyMatrixBlocks(viewProjection, worldBlocks.data(), resultBlocks.data(), blockCount);
+    f64 blocksMs = MillisecondsSince(start) / iterations;
+
+    start = Clock::now();
+    for (u32 iteration = 0; iteration < iterations; ++iteration)
+    {
+        PackMatrixBlocks(worlds.data(), matrixCount, worldBlocks.data());
+        MultiplyMatrixBlocks(viewProjection, worldBlocks.data(), resultBlocks.data(), blockCount);
+        UnpackMatrixBlocks(resultBlocks.data(), matrixCount, blockResults.data());
+    }
+    f64 convertedMs = MillisecondsSince(start) / iterations;
+
+    printf("%s kernels, %u matrices x %u iterations\n", GetMatrixKernelsISA(), matrixCount, iterations);
+    printf("%-22s %10s %8s %12s\n", "path", "ms", "speedup", "max error");
+    printf("%-22s %10.3f %7.2fx %12s\n", "glm", glmMs, 1.0, "-");
+    printf("%-22s %10.3f %7.2fx %12g\n", "arrays", arraysMs, glmMs / arraysMs, MaxError(reference, results));
+    printf("%-22s %10.3f %7.2fx %12s\n", "blocks", blocksMs, glmMs / blocksMs, "-");
+    printf("%-22s %10.3f %7.2fx %12g\n", "blocks + conversion", convertedMs, glmMs / convertedMs, MaxError(reference, blockResults));
+    return 0;
+}
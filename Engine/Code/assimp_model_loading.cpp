@@ -3,164 +3,186 @@
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
 #include "engine.h"
+#include "mesh_cache.h"
+#include <float.h>
 #include <iostream>
 
-void ProcessAssimpMaterial(App* app, aiMaterial* material, Material& myMaterial, String directory)
+//Without Assimp (ENGINE_NO_ASSIMP) the importer is compiled out and models only load from
+//their mesh cache, so engine_core still links for the tests and CPU-only tools
+#ifndef ENGINE_NO_ASSIMP
+static void CopyCacheString(char* dst, u32 dstSize, const aiString& src)
+{
+	u32 length = src.length;
+	if (length >= dstSize)
+	{
+		ELOG("Name %s is too long for the mesh cache and will be truncated", src.C_Str());
+		length = dstSize - 1;
+	}
+	memcpy(dst, src.C_Str(), length);
+	dst[length] = '\0';
+}
+
+void ProcessAssimpMaterial(aiMaterial* material, MeshCacheMaterial& myMaterial)
 {
 	aiString name;
 	aiColor3D diffuseColor;
 	aiColor3D emissiveColor;
 	aiColor3D specularColor;
-	ai_real shininess;
+	ai_real shininess = 0.0f;
 	material->Get(AI_MATKEY_NAME, name);
 	material->Get(AI_MATKEY_COLOR_DIFFUSE, diffuseColor);
 	material->Get(AI_MATKEY_COLOR_EMISSIVE, emissiveColor);
 	material->Get(AI_MATKEY_COLOR_SPECULAR, specularColor);
 	material->Get(AI_MATKEY_SHININESS, shininess);
 
-	myMaterial.name = name.C_Str();
-	myMaterial.albedo = vec3(diffuseColor.r, diffuseColor.g, diffuseColor.b);
-	myMaterial.emissive = vec3(emissiveColor.r, emissiveColor.g, emissiveColor.b);
-	myMaterial.specular = vec3(specularColor.r, specularColor.g, specularColor.b);
+	myMaterial = {};
+	CopyCacheString(myMaterial.name, MESH_CACHE_NAME_LENGTH, name);
+	myMaterial.albedo[0] = diffuseColor.r; myMaterial.albedo[1] = diffuseColor.g; myMaterial.albedo[2] = diffuseColor.b;
+	myMaterial.emissive[0] = emissiveColor.r; myMaterial.emissive[1] = emissiveColor.g; myMaterial.emissive[2] = emissiveColor.b;
+	myMaterial.specular[0] = specularColor.r; myMaterial.specular[1] = specularColor.g; myMaterial.specular[2] = specularColor.b;
 	myMaterial.smoothness = shininess / 256.0f;
 
+	const aiTextureType textureTypes[MeshCacheTexture_Count] = {
+		aiTextureType_DIFFUSE,
+		aiTextureType_EMISSIVE,
+		aiTextureType_SPECULAR,
+		aiTextureType_NORMALS,
+		aiTextureType_HEIGHT
+	};
+
 	aiString aiFilename;
-	if (material->GetTextureCount(aiTextureType_DIFFUSE) > 0)
+	for (u32 slot = 0; slot < MeshCacheTexture_Count; ++slot)
 	{
-		material->GetTexture(aiTextureType_DIFFUSE, 0, &aiFilename);
-		String filename = MakeString(aiFilename.C_Str());
-		String filepath = MakePath(directory, filename);
-		myMaterial.albedoTextureIdx = LoadTexture2D(app, filepath.str);
+		if (material->GetTextureCount(textureTypes[slot]) > 0)
+		{
+			material->GetTexture(textureTypes[slot], 0, &aiFilename);
+			CopyCacheString(myMaterial.textures[slot], MESH_CACHE_PATH_LENGTH, aiFilename);
+		}
 	}
-	if (material->GetTextureCount(aiTextureType_EMISSIVE) > 0)
+}
+
+void DescribeAssimpMesh(aiMesh* mesh, MeshCacheSubmesh& submesh)
+{
+	const bool hasTexCoords = mesh->mTextureCoords[0] != nullptr;
+	const bool hasTangentSpace = mesh->mTangents != nullptr && mesh->mBitangents != nullptr;
+
+	//--Create the vertex format--
+	u32 attributeCount = 0;
+	u32 stride = 0;
+	submesh.attributes[attributeCount++] = { 0, 3, (u8)stride, 0 };
+	stride += 3 * sizeof(float);
+	submesh.attributes[attributeCount++] = { 1, 3, (u8)stride, 0 };
+	stride += 3 * sizeof(float);
+	if (hasTexCoords)
 	{
-		material->GetTexture(aiTextureType_EMISSIVE, 0, &aiFilename);
-		String filename = MakeString(aiFilename.C_Str());
-		String filepath = MakePath(directory, filename);
-		myMaterial.emissiveTextureIdx = LoadTexture2D(app, filepath.str);
+		submesh.attributes[attributeCount++] = { 2, 2, (u8)stride, 0 };
+		stride += 2 * sizeof(float);
 	}
-	if (material->GetTextureCount(aiTextureType_SPECULAR) > 0)
+	if (hasTangentSpace)
 	{
-		material->GetTexture(aiTextureType_SPECULAR, 0, &aiFilename);
-		String filename = MakeString(aiFilename.C_Str());
-		String filepath = MakePath(directory, filename);
-		myMaterial.specularTextureIdx = LoadTexture2D(app, filepath.str);
+		submesh.attributes[attributeCount++] = { 3, 3, (u8)stride, 0 };
+		stride += 3 * sizeof(float);
+		submesh.attributes[attributeCount++] = { 4, 3, (u8)stride, 0 };
+		stride += 3 * sizeof(float);
 	}
-	if (material->GetTextureCount(aiTextureType_NORMALS) > 0)
+	submesh.attributeCount = attributeCount;
+	submesh.stride = stride;
+
+	//--Bounding box, used for culling--
+	for (u32 axis = 0; axis < 3; ++axis)
 	{
-		material->GetTexture(aiTextureType_NORMALS, 0, &aiFilename);
-		String filename = MakeString(aiFilename.C_Str());
-		String filepath = MakePath(directory, filename);
-		myMaterial.normalsTextureIdx = LoadTexture2D(app, filepath.str);
+		submesh.boundsMin[axis] = mesh->mNumVertices > 0 ? FLT_MAX : 0.0f;
+		submesh.boundsMax[axis] = mesh->mNumVertices > 0 ? -FLT_MAX : 0.0f;
 	}
-	if (material->GetTextureCount(aiTextureType_HEIGHT) > 0)
+	for (unsigned int i = 0; i < mesh->mNumVertices; i++)
 	{
-		material->GetTexture(aiTextureType_HEIGHT, 0, &aiFilename);
-		String filename = MakeString(aiFilename.C_Str());
-		String filepath = MakePath(directory, filename);
-		myMaterial.bumpTextureIdx = LoadTexture2D(app, filepath.str);
+		const aiVector3D& position = mesh->mVertices[i];
+		for (u32 axis = 0; axis < 3; ++axis)
+		{
+			submesh.boundsMin[axis] = fminf(submesh.boundsMin[axis], position[axis]);
+			submesh.boundsMax[axis] = fmaxf(submesh.boundsMax[axis], position[axis]);
+		}
 	}
+
+	//--Count the indices--
+	submesh.indexCount = 0;
+	for (unsigned int i = 0; i < mesh->mNumFaces; i++)
+		submesh.indexCount += mesh->mFaces[i].mNumIndices;
+
+	//--Store the material for this mesh--
+	submesh.materialIdx = mesh->mMaterialIndex;
 }
 
-void ProcessAssimpMesh(const aiScene* scene, aiMesh* mesh, Mesh* myMesh, u32 baseMeshMaterialIndex, std::vector<u32>& submeshMaterialIndices)
+void ProcessAssimpMesh(aiMesh* mesh, const MeshCacheSubmesh& submesh, u8* vertexData, u8* indexData)
 {
-	std::vector<float> vertices;
-	std::vector<u32> indices;
-
-	bool hasTexCoords = false;
-	bool hasTangentSpace = false;
+	const bool hasTexCoords = mesh->mTextureCoords[0] != nullptr;
+	const bool hasTangentSpace = mesh->mTangents != nullptr && mesh->mBitangents != nullptr;
 
-	//--Process vertices--
+	//--Process vertices: interleave them straight into the destination--
+	f32* vertices = (f32*)(vertexData + submesh.vertexOffset);
 	for (unsigned int i = 0; i < mesh->mNumVertices; i++)
 	{
-		vertices.push_back(mesh->mVertices[i].x);
-		vertices.push_back(mesh->mVertices[i].y);
-		vertices.push_back(mesh->mVertices[i].z);
-		vertices.push_back(mesh->mNormals[i].x);
-		vertices.push_back(mesh->mNormals[i].y);
-		vertices.push_back(mesh->mNormals[i].z);
-
-		if (mesh->mTextureCoords[0])
+		*vertices++ = mesh->mVertices[i].x;
+		*vertices++ = mesh->mVertices[i].y;
+		*vertices++ = mesh->mVertices[i].z;
+		*vertices++ = mesh->mNormals[i].x;
+		*vertices++ = mesh->mNormals[i].y;
+		*vertices++ = mesh->mNormals[i].z;
+
+		if (hasTexCoords)
 		{
-			hasTexCoords = true;
-			vertices.push_back(mesh->mTextureCoords[0][i].x);
-			vertices.push_back(mesh->mTextureCoords[0][i].y);
+			*vertices++ = mesh->mTextureCoords[0][i].x;
+			*vertices++ = mesh->mTextureCoords[0][i].y;
 		}
 
-		if (mesh->mTangents != nullptr && mesh->mBitangents)
+		if (hasTangentSpace)
 		{
-			hasTangentSpace = true;
-			vertices.push_back(mesh->mTangents[i].x);
-			vertices.push_back(mesh->mTangents[i].y);
-			vertices.push_back(mesh->mTangents[i].z);
+			*vertices++ = mesh->mTangents[i].x;
+			*vertices++ = mesh->mTangents[i].y;
+			*vertices++ = mesh->mTangents[i].z;
 
 			// ASSIMP gives the bitangents flipped
 			// Easiest solution I found was to invert the components of the bitangent
-			vertices.push_back(-mesh->mBitangents[i].x);
-			vertices.push_back(-mesh->mBitangents[i].y);
-			vertices.push_back(-mesh->mBitangents[i].z);
+			*vertices++ = -mesh->mBitangents[i].x;
+			*vertices++ = -mesh->mBitangents[i].y;
+			*vertices++ = -mesh->mBitangents[i].z;
 		}
 	}
 
 	//--Process indices--
+	u32* indices = (u32*)(indexData + submesh.indexOffset);
 	for (unsigned int i = 0; i < mesh->mNumFaces; i++)
 	{
-		aiFace face = mesh->mFaces[i];
+		const aiFace& face = mesh->mFaces[i];
 		for (unsigned int j = 0; j < face.mNumIndices; j++)
 		{
-			indices.push_back(face.mIndices[j]);
+			*indices++ = face.mIndices[j];
 		}
 	}
-
-	//--Store the material for this mesh--
-	submeshMaterialIndices.push_back(baseMeshMaterialIndex + mesh->mMaterialIndex);
-
-	//--Create the vertex format--
-	VertexBufferLayout vertexBufferLayout = VertexBufferLayout();
-	vertexBufferLayout.attributes.push_back(VertexBufferAttribute{ 0, 3, 0 });
-	vertexBufferLayout.attributes.push_back(VertexBufferAttribute{ 1, 3, 3 * sizeof(float) });
-	vertexBufferLayout.stride = 6 * sizeof(float);
-	if (hasTexCoords)
-	{
-		vertexBufferLayout.attributes.push_back(VertexBufferAttribute{ 2, 2, vertexBufferLayout.stride });
-		vertexBufferLayout.stride += 2 * sizeof(float);
-	}
-	if (hasTangentSpace)
-	{
-		vertexBufferLayout.attributes.push_back(VertexBufferAttribute{ 3, 3, vertexBufferLayout.stride });
-		vertexBufferLayout.stride += 3 * sizeof(float);
-
-		vertexBufferLayout.attributes.push_back(VertexBufferAttribute{ 4, 3, vertexBufferLayout.stride });
-		vertexBufferLayout.stride += 3 * sizeof(float);
-	}
-
-	//--Add the submesh into the mesh--
-	Submesh submesh = Submesh();
-	submesh.vertexBufferLayout = vertexBufferLayout;
-	submesh.vertices.swap(vertices);
-	submesh.indices.swap(indices);
-	myMesh->submeshes.push_back(submesh);
 }
 
-void ProcessAssimpNode(const aiScene* scene, aiNode* node, Mesh* myMesh, u32 baseMeshMaterialIndex, std::vector<u32>& submeshMaterialIndices)
+void ProcessAssimpNode(const aiScene* scene, aiNode* node, std::vector<aiMesh*>& meshes)
 {
 	//--Process all the node's meshes--
 	for (unsigned int i = 0; i < node->mNumMeshes; i++)
 	{
-		aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
-		ProcessAssimpMesh(scene, mesh, myMesh, baseMeshMaterialIndex, submeshMaterialIndices);
+		meshes.push_back(scene->mMeshes[node->mMeshes[i]]);
 	}
 
 	//--Loop for each children--
 	for (unsigned int i = 0; i < node->mNumChildren; i++)
 	{
-		ProcessAssimpNode(scene, node->mChildren[i], myMesh, baseMeshMaterialIndex, submeshMaterialIndices);
+		ProcessAssimpNode(scene, node->mChildren[i], meshes);
 	}
 }
 
+#endif
+
 u32 LoadModel(App* app, const char* filename)
 {
-	const aiScene* scene = aiImportFile(filename,
+	PROFILE_SCOPE("LoadModel");
+
+	const u32 importFlags =
 		aiProcess_Triangulate |
 		aiProcess_GenSmoothNormals |
 		aiProcess_CalcTangentSpace |
@@ -168,7 +190,19 @@ u32 LoadModel(App* app, const char* filename)
 		aiProcess_PreTransformVertices |
 		aiProcess_ImproveCacheLocality |
 		aiProcess_OptimizeMeshes |
-		aiProcess_SortByPType);
+		aiProcess_SortByPType;
+
+	//--Skip the import if the cache still matches the source--
+	const u64 sourceHash = HashModelSource(filename);
+	u32 modelIdx = LoadModelFromCache(app, filename, sourceHash, importFlags);
+	if (modelIdx != UINT32_MAX)
+		return modelIdx;
+
+#ifdef ENGINE_NO_ASSIMP
+	ELOG("Cannot import %s: built without Assimp and there is no valid mesh cache for it", filename);
+	return UINT32_MAX;
+#else
+	const aiScene* scene = aiImportFile(filename, importFlags);
 
 	if (!scene)
 	{
@@ -176,67 +210,64 @@ u32 LoadModel(App* app, const char* filename)
 		return UINT32_MAX;
 	}
 
-	app->meshes.push_back(Mesh{});
-	Mesh& mesh = app->meshes.back();
-	u32 meshIdx = (u32)app->meshes.size() - 1u;
-
-	app->models.push_back(Model{});
-	Model& model = app->models.back();
-	model.meshIdx = meshIdx;
-	u32 modelIdx = (u32)app->models.size() - 1u;
-
-	String directory = GetDirectoryPart(MakeString(filename));
-
-	//--Create a list of materials--
-	u32 baseMeshMaterialIndex = (u32)app->materials.size();
+	//--Describe the materials and submeshes so the final data layout is known up front--
+	std::vector<MeshCacheMaterial> materials(scene->mNumMaterials);
 	for (unsigned int i = 0; i < scene->mNumMaterials; ++i)
 	{
-		app->materials.push_back(Material{});
-		Material& material = app->materials.back();
-		ProcessAssimpMaterial(app, scene->mMaterials[i], material, directory);
+		ProcessAssimpMaterial(scene->mMaterials[i], materials[i]);
 	}
 
-	ProcessAssimpNode(scene, scene->mRootNode, &mesh, baseMeshMaterialIndex, model.materialIdx);
+	std::vector<aiMesh*> meshes;
+	ProcessAssimpNode(scene, scene->mRootNode, meshes);
 
-	aiReleaseImport(scene);
+	MeshCacheHeader header = {};
+	header.magic = MESH_CACHE_MAGIC;
+	header.version = MESH_CACHE_VERSION;
+	header.sourceHash = sourceHash;
+	header.importFlags = importFlags;
+	header.submeshCount = (u32)meshes.size();
+	header.materialCount = (u32)materials.size();
 
-	u32 vertexBufferSize = 0;
-	u32 indexBufferSize = 0;
-
-	for (u32 i = 0; i < mesh.submeshes.size(); ++i)
+	std::vector<MeshCacheSubmesh> submeshes(meshes.size());
+	for (u32 i = 0; i < meshes.size(); ++i)
 	{
-		vertexBufferSize += mesh.submeshes[i].vertices.size() * sizeof(float);
-		indexBufferSize += mesh.submeshes[i].indices.size() * sizeof(u32);
+		MeshCacheSubmesh& submesh = submeshes[i];
+		submesh = {};
+		DescribeAssimpMesh(meshes[i], submesh);
+		submesh.vertexOffset = header.vertexDataSize;
+		submesh.indexOffset = header.indexDataSize;
+		header.vertexDataSize += meshes[i]->mNumVertices * submesh.stride;
+		header.indexDataSize += submesh.indexCount * sizeof(u32);
 	}
 
-	glGenBuffers(1, &mesh.vertexBufferHandle);
-	glBindBuffer(GL_ARRAY_BUFFER, mesh.vertexBufferHandle);
-	glBufferData(GL_ARRAY_BUFFER, vertexBufferSize, NULL, GL_STATIC_DRAW);
-
-	glGenBuffers(1, &mesh.indexBufferHandle);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.indexBufferHandle);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexBufferSize, NULL, GL_STATIC_DRAW);
-
-	u32 indicesOffset = 0;
-	u32 verticesOffset = 0;
-
-	for (u32 i = 0; i < mesh.submeshes.size(); ++i)
+	//--Bake straight into the cache file and load it like any other cached model--
+	//The import is kept until the cache reads back, it may have been replaced meanwhile
+	MeshCacheFile cacheFile = CreateMeshCacheFile(filename, header, submeshes.data(), materials.data());
+	if (cacheFile.vertexData)
 	{
-		const void* verticesData = mesh.submeshes[i].vertices.data();
-		const u32   verticesSize = mesh.submeshes[i].vertices.size() * sizeof(float);
-		glBufferSubData(GL_ARRAY_BUFFER, verticesOffset, verticesSize, verticesData);
-		mesh.submeshes[i].vertexOffset = verticesOffset;
-		verticesOffset += verticesSize;
-
-		const void* indicesData = mesh.submeshes[i].indices.data();
-		const u32 indicesSize = mesh.submeshes[i].indices.size() * sizeof(u32);
-		glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, indicesOffset, indicesSize, indicesData);
-		mesh.submeshes[i].indexOffset = indicesOffset;
-		indicesOffset += indicesSize;
+		for (u32 i = 0; i < meshes.size(); ++i)
+			ProcessAssimpMesh(meshes[i], submeshes[i], cacheFile.vertexData, cacheFile.indexData);
+
+		if (CloseMeshCacheFile(cacheFile))
+		{
+			modelIdx = LoadModelFromCache(app, filename, sourceHash, importFlags);
+			if (modelIdx != UINT32_MAX)
+			{
+				aiReleaseImport(scene);
+				return modelIdx;
+			}
+		}
+		ELOG("The mesh cache of %s could not be loaded back, using the imported data", filename);
 	}
 
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	//--The cache cannot be written or read back here: build the data in memory instead--
+	std::vector<u8> vertexData(header.vertexDataSize);
+	std::vector<u8> indexData(header.indexDataSize);
+	for (u32 i = 0; i < meshes.size(); ++i)
+		ProcessAssimpMesh(meshes[i], submeshes[i], vertexData.data(), indexData.data());
+
+	aiReleaseImport(scene);
 
-	return modelIdx;
+	return CreateModelFromCache(app, filename, header, submeshes.data(), materials.data(), vertexData.data(), indexData.data());
+#endif
 }
@@ -2,18 +2,22 @@
 
 #include <vector>
 
+typedef unsigned char u8;
 typedef unsigned int u32;
 
 struct App;
 struct Mesh;
 struct Material;
+struct MeshCacheMaterial;
+struct MeshCacheSubmesh;
 struct String;
 struct aiMaterial;
 struct aiScene;
 struct aiMesh;
 struct aiNode;
 
-void ProcessAssimpMaterial(App* app, aiMaterial* material, Material& myMaterial, String directory);
-void ProcessAssimpMesh(const aiScene* scene, aiMesh* mesh, Mesh* myMesh, u32 baseMeshMaterialIndex, std::vector<u32>& submeshMaterialIndices);
-void ProcessAssimpNode(const aiScene* scene, aiNode* node, Mesh* myMesh, u32 baseMeshMaterialIndex, std::vector<u32>& submeshMaterialIndices);
+void ProcessAssimpMaterial(aiMaterial* material, MeshCacheMaterial& myMaterial);
+void DescribeAssimpMesh(aiMesh* mesh, MeshCacheSubmesh& submesh);
+void ProcessAssimpMesh(aiMesh* mesh, const MeshCacheSubmesh& submesh, u8* vertexData, u8* indexData);
+void ProcessAssimpNode(const aiScene* scene, aiNode* node, std::vector<aiMesh*>& meshes);
 u32 LoadModel(App* app, const char* filename);
@@ -0,0 +1,336 @@
+#include "benchmark.h"
+#include "engine.h"
+#include <algorithm>
+#include <fstream>
+#include <math.h>
+#include <sstream>
+#include <stdlib.h>
+
+//JSON layout, one object per metric with all times in milliseconds:
+//{
+//  "scene": "benchmarks/default.scene", "frames": 600, "warmupFrames": 30, "deltaTime": 0.016667,
+//  "metrics": {
+//    "cpu_ms": {"samples": 600, "min": 1.2, "avg": 1.4, "p50": 1.3, "p90": 1.6, "p95": 1.7, "p99": 2.1, "max": 3.0},
+//    "frame_ms": {...}, "gpu_frame_ms": {...}, "gpu_geometry_ms": {...}, ...
+//  }
+//}
+
+static const char* const s_passMetricNames[GpuTimerPass_Count] = {
+    "gpu_geometry_ms",
+    "gpu_lighting_ms",
+    "gpu_post_processing_ms"
+};
+
+//Compared against the baseline; the per pass times are only reported
+static const char* const s_comparedMetrics[] = { "cpu_ms", "frame_ms", "gpu_frame_ms" };
+static const char* const s_comparedPercentiles[] = { "p50", "p95", "p99" };
+
+static const std::vector<f32>& GetMetricSamples(const BenchmarkSamples& samples, const std::string& metric)
+{
+    if (metric == "cpu_ms")
+        return samples.cpuMilliseconds;
+    if (metric == "frame_ms")
+        return samples.frameMilliseconds;
+    if (metric == "gpu_frame_ms")
+        return samples.gpuFrameMilliseconds;
+    for (u32 pass = 0; pass < GpuTimerPass_Count; ++pass)
+        if (metric == s_passMetricNames[pass])
+            return samples.gpuPassMilliseconds[pass];
+    ASSERT(false, "Unknown benchmark metric");
+    return samples.cpuMilliseconds;
+}
+
+static f32 GetPercentile(const BenchmarkPercentiles& percentiles, const std::string& name)
+{
+    if (name == "p50")
+        return percentiles.p50;
+    if (name == "p95")
+        return percentiles.p95;
+    return percentiles.p99;
+}
+
+BenchmarkPercentiles ComputePercentiles(std::vector<f32> samples)
+{
+    BenchmarkPercentiles percentiles;
+    if (samples.empty())
+        return percentiles;
+
+    std::sort(samples.begin(), samples.end());
+    f64 sum = 0.0;
+    for (f32 sample : samples)
+        sum += sample;
+
+    //Nearest rank
+    auto percentile = [&samples](f32 fraction)
+    {
+        size_t rank = (size_t)ceil(fraction * samples.size());
+        return samples[rank > 0 ? rank - 1 : 0];
+    };
+
+    percentiles.min = samples.front();
+    percentiles.average = (f32)(sum / samples.size());
+    percentiles.p50 = percentile(0.50f);
+    percentiles.p90 = percentile(0.90f);
+    percentiles.p95 = percentile(0.95f);
+    percentiles.p99 = percentile(0.99f);
+    percentiles.max = samples.back();
+    return percentiles;
+}
+
+static void WriteMetric(FILE* file, const char* name, const std::vector<f32>& samples, bool isLast)
+{
+    BenchmarkPercentiles percentiles = ComputePercentiles(samples);
+    fprintf(file, "    \"%s\": {\"samples\": %u, \"min\": %.4f, \"avg\": %.4f, \"p50\": %.4f, \"p90\": %.4f, \"p95\": %.4f, \"p99\": %.4f, \"max\": %.4f}%s\n",
+        name, (u32)samples.size(), percentiles.min, percentiles.average, percentiles.p50, percentiles.p90,
+        percentiles.p95, percentiles.p99, percentiles.max, isLast ? "" : ",");
+}
+
+bool WriteBenchmarkJson(const char* filepath, const BenchmarkOptions& options, u32 measuredFrames, const BenchmarkSamples& samples)
+{
+    FILE* file = fopen(filepath, "wb");
+    if (!file)
+    {
+        ELOG("Could not open %s to write the benchmark results", filepath);
+        return false;
+    }
+
+    std::string scene = options.scenePath ? options.scenePath : options.stress ? "stress" : "built-in";
+    std::replace(scene.begin(), scene.end(), '\\', '/');
+
+    fprintf(file, "{\n");
+    fprintf(file, "  \"scene\": \"%s\",\n", scene.c_str());
+    fprintf(file, "  \"frames\": %u,\n", measuredFrames);
+    fprintf(file, "  \"warmupFrames\": %u,\n", options.warmupFrames);
+    fprintf(file, "  \"deltaTime\": %.6f,\n", options.fixedDeltaTime);
+    fprintf(file, "  \"metrics\": {\n");
+    WriteMetric(file, "cpu_ms", samples.cpuMilliseconds, false);
+    WriteMetric(file, "frame_ms", samples.frameMilliseconds, false);
+    WriteMetric(file, "gpu_frame_ms", samples.gpuFrameMilliseconds, false);
+    for (u32 pass = 0; pass < GpuTimerPass_Count; ++pass)
+        WriteMetric(file, s_passMetricNames[pass], samples.gpuPassMilliseconds[pass], pass + 1 == GpuTimerPass_Count);
+    fprintf(file, "  }\n}\n");
+
+    bool success = ferror(file) == 0;
+    fclose(file);
+    return success;
+}
+
+//Only reads what WriteBenchmarkJson writes: the number after "key" inside the "metric" object
+static bool FindMetricValue(const std::string& json, const char* metric, const char* key, f64& value)
+{
+    size_t metricStart = json.find(std::string("\"") + metric + "\"");
+    if (metricStart == std::string::npos)
+        return false;
+    size_t metricEnd = json.find('}', metricStart);
+    size_t keyStart = json.find(std::string("\"") + key + "\"", metricStart);
+    if (keyStart == std::string::npos || keyStart > metricEnd)
+        return false;
+    size_t colon = json.find(':', keyStart);
+    if (colon == std::string::npos || colon > metricEnd)
+        return false;
+
+    const char* number = json.c_str() + colon + 1;
+    char* end = NULL;
+    value = strtod(number, &end);
+    return end != number;
+}
+
+i32 CheckBenchmarkRegressions(const BenchmarkSamples& samples, const char* baselinePath, f32 threshold)
+{
+    std::ifstream file(baselinePath);
+    if (!file)
+    {
+        ELOG("Could not open the benchmark baseline %s", baselinePath);
+        return -1;
+    }
+    std::stringstream stream;
+    stream << file.rdbuf();
+    const std::string baseline = stream.str();
+
+    i32 regressions = 0;
+    for (const char* metric : s_comparedMetrics)
+    {
+        const std::vector<f32>& metricSamples = GetMetricSamples(samples, metric);
+        if (metricSamples.empty())
+            continue;
+        BenchmarkPercentiles current = ComputePercentiles(metricSamples);
+
+        for (const char* percentile : s_comparedPercentiles)
+        {
+            f64 baselineValue = 0.0;
+            if (!FindMetricValue(baseline, metric, percentile, baselineValue) || baselineValue <= 0.0)
+                continue;
+
+            f32 currentValue = GetPercentile(current, percentile);
+            f64 growth = currentValue / baselineValue - 1.0;
+            if (growth > threshold)
+            {
+                ELOG("Benchmark regression: %s %s %.3f ms vs %.3f ms in the baseline (+%.1f%%, threshold %.1f%%)",
+                    metric, percentile, currentValue, baselineValue, growth * 100.0, threshold * 100.0f);
+                ++regressions;
+            }
+        }
+    }
+    return regressions;
+}
+
+struct BenchmarkState
+{
+    const BenchmarkOptions* options;
+    const SceneDescription* scene;
+    BenchmarkSamples samples;
+    u32 lastResolvedFrames;
+};
+
+static void BeforeBenchmarkFrame(App* app, u32 frame, void* user)
+{
+    BenchmarkState& state = *(BenchmarkState*)user;
+
+    //Streamed scene textures are in place before the first measured frame
+    if (frame == state.options->warmupFrames)
+        FlushTextureStreaming(app);
+
+    if (!state.scene || state.scene->cameraPath.empty())
+        return;
+
+    //The camera waits at the start of its path during the warmup
+    u32 measuredFrame = frame > state.options->warmupFrames ? frame - state.options->warmupFrames : 0;
+    CameraKey key = SampleCameraPath(state.scene->cameraPath, measuredFrame * state.options->fixedDeltaTime);
+    app->camera.cameraPos = key.position;
+    app->camera.yaw = key.yaw;
+    app->camera.pitch = key.pitch;
+}
+
+static void AfterBenchmarkFrame(App* app, u32 frame, f64 cpuMilliseconds, f64 frameMilliseconds, void* user)
+{
+    BenchmarkState& state = *(BenchmarkState*)user;
+    const GpuTimers& timers = app->gpuTimers;
+    bool hasGpuSample = timers.resolvedFrames != state.lastResolvedFrames;
+    state.lastResolvedFrames = timers.resolvedFrames;
+    if (frame < state.options->warmupFrames)
+        return;
+
+    BenchmarkSamples& samples = state.samples;
+    samples.cpuMilliseconds.push_back((f32)cpuMilliseconds);
+    samples.frameMilliseconds.push_back((f32)frameMilliseconds);
+
+    //The GPU times arrive a few frames late, a couple of warmup frames get in but the
+    //last measured frames never do
+    if (hasGpuSample)
+    {
+        samples.gpuFrameMilliseconds.push_back(GetLatestTimingSample(timers.gpuFrames));
+        for (u32 pass = 0; pass < GpuTimerPass_Count; ++pass)
+            samples.gpuPassMilliseconds[pass].push_back(GetLatestTimingSample(timers.passes[pass]));
+    }
+}
+
+static void LogPercentiles(const char* name, const std::vector<f32>& samples)
+{
+    BenchmarkPercentiles percentiles = ComputePercentiles(samples);
+    ILOG("Benchmark: %-16s avg %8.3f  p50 %8.3f  p95 %8.3f  p99 %8.3f  max %8.3f ms", name,
+        percentiles.average, percentiles.p50, percentiles.p95, percentiles.p99, percentiles.max);
+}
+
+bool WriteScalingCsv(const char* filepath, const char* parameter, const std::vector<u32>& values, const std::vector<BenchmarkSamples>& runs)
+{
+    ASSERT(values.size() == runs.size(), "Every run needs its parameter value");
+    FILE* file = fopen(filepath, "wb");
+    if (!file)
+    {
+        ELOG("Could not open %s to write the scaling results", filepath);
+        return false;
+    }
+
+    std::vector<std::string> metrics(s_comparedMetrics, s_comparedMetrics + ARRAY_COUNT(s_comparedMetrics));
+    metrics.insert(metrics.end(), s_passMetricNames, s_passMetricNames + GpuTimerPass_Count);
+
+    fprintf(file, "%s", parameter);
+    for (const std::string& metric : metrics)
+        fprintf(file, ",%s_avg,%s_p50,%s_p95", metric.c_str(), metric.c_str(), metric.c_str());
+    fprintf(file, "\n");
+
+    for (u32 run = 0; run < runs.size(); ++run)
+    {
+        fprintf(file, "%u", values[run]);
+        for (const std::string& metric : metrics)
+        {
+            BenchmarkPercentiles percentiles = ComputePercentiles(GetMetricSamples(runs[run], metric));
+            fprintf(file, ",%.4f,%.4f,%.4f", percentiles.average, percentiles.p50, percentiles.p95);
+        }
+        fprintf(file, "\n");
+    }
+
+    bool success = ferror(file) == 0;
+    fclose(file);
+    return success;
+}
+
+int RunBenchmark(App* app, const BenchmarkOptions& options, BenchmarkSamples* samples)
+{
+    SceneDescription scene;
+    if (options.scenePath && !ParseSceneDescription(options.scenePath, scene))
+        return -1;
+    if (options.stress)
+        GenerateStressScene(*options.stress, scene);
+    if (options.scenePath || options.stress)
+        app->scene = &scene;
+
+    u32 measuredFrames = options.frames;
+    if (measuredFrames == 0)
+    {
+        f32 duration = GetCameraPathDuration(scene.cameraPath);
+        measuredFrames = duration > 0.0f ? (u32)ceilf(duration / options.fixedDeltaTime) + 1 : BENCHMARK_DEFAULT_FRAMES;
+    }
+
+    BenchmarkState state = {};
+    state.options = &options;
+    state.scene = app->scene;
+
+    HeadlessRun run;
+    run.frameCount = options.warmupFrames + measuredFrames;
+    run.fixedDeltaTime = options.fixedDeltaTime;
+    run.user = &state;
+    run.beforeFrame = BeforeBenchmarkFrame;
+    run.afterFrame = AfterBenchmarkFrame;
+
+    app->deltaTime = options.fixedDeltaTime;
+    int result = RunHeadless(app, run);
+    app->scene = NULL;
+    if (result != 0 || state.samples.cpuMilliseconds.size() < measuredFrames)
+    {
+        ELOG("Benchmark: the run did not complete");
+        return -1;
+    }
+    if (app->textureStreamer.failedRequests > 0)
+    {
+        ELOG("Benchmark: %u scene textures could not be streamed", app->textureStreamer.failedRequests);
+        return -1;
+    }
+
+    LogPercentiles("CPU", state.samples.cpuMilliseconds);
+    LogPercentiles("Frame", state.samples.frameMilliseconds);
+    LogPercentiles("GPU frame", state.samples.gpuFrameMilliseconds);
+    for (u32 pass = 0; pass < GpuTimerPass_Count; ++pass)
+        LogPercentiles(GetGpuTimerPassName((GpuTimerPass)pass), state.samples.gpuPassMilliseconds[pass]);
+
+    if (samples)
+        *samples = state.samples;
+
+    if (options.jsonPath)
+    {
+        if (!WriteBenchmarkJson(options.jsonPath, options, measuredFrames, state.samples))
+            return -1;
+        ILOG("Benchmark: results written to %s", options.jsonPath);
+    }
+
+    if (options.baselinePath)
+    {
+        i32 regressions = CheckBenchmarkRegressions(state.samples, options.baselinePath, options.regressionThreshold);
+        if (regressions < 0)
+            return -1;
+        if (regressions > 0)
+            return 1;
+        ILOG("Benchmark: no regression over %.1f%% against %s", options.regressionThreshold * 100.0f, options.baselinePath);
+    }
+    return 0;
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "platform.h"
+#include "gpu_timers.h"
+#include "scene.h"
+#include <string>
+
+//Scripted benchmark runs: a scene description is loaded in place of the built-in scene, the
+//camera follows its path with a fixed delta time so every run renders the same frames, and
+//the CPU, whole frame and GPU times of every frame are collected. The results are written
+//as JSON with percentiles and can be checked against the JSON of an earlier run: the run
+//fails if any of the compared percentiles grew by more than the threshold.
+//Scaling tests run the benchmark on generated stress scenes, once per value of the swept
+//parameter, and write one CSV row of percentiles per run to chart how the times grow.
+
+#define BENCHMARK_DEFAULT_FRAMES 600
+
+struct App;
+
+struct BenchmarkOptions
+{
+    const char* scenePath = NULL;    //Built-in scene with a still camera when NULL
+    u32 frames = 0;                  //0: the length of the camera path, or BENCHMARK_DEFAULT_FRAMES
+    u32 warmupFrames = 30;           //Rendered before the measured frames, not measured
+    f32 fixedDeltaTime = 1.0f / 60.0f;
+    const char* jsonPath = NULL;
+    const char* baselinePath = NULL;
+    f32 regressionThreshold = 0.1f;  //Relative growth allowed over the baseline
+    const StressSceneOptions* stress = NULL; //Generated on top of the scene when set
+};
+
+struct BenchmarkSamples
+{
+    std::vector<f32> cpuMilliseconds;   //Update + Render
+    std::vector<f32> frameMilliseconds; //Including the wait for the GPU
+    std::vector<f32> gpuFrameMilliseconds;
+    std::vector<f32> gpuPassMilliseconds[GpuTimerPass_Count];
+};
+
+struct BenchmarkPercentiles
+{
+    f32 min = 0.0f;
+    f32 average = 0.0f;
+    f32 p50 = 0.0f;
+    f32 p90 = 0.0f;
+    f32 p95 = 0.0f;
+    f32 p99 = 0.0f;
+    f32 max = 0.0f;
+};
+
+BenchmarkPercentiles ComputePercentiles(std::vector<f32> samples);
+
+/**
+ * Writes the percentiles of every sampled metric, see benchmark.cpp for the layout.
+ */
+bool WriteBenchmarkJson(const char* filepath, const BenchmarkOptions& options, u32 measuredFrames, const BenchmarkSamples& samples);
+
+/**
+ * Compares the p50/p95/p99 of the CPU, frame and GPU frame times against the ones of the
+ * benchmark JSON at baselinePath. Logs every regression over the threshold and returns how
+ * many there were, or -1 if the baseline cannot be read.
+ */
+i32 CheckBenchmarkRegressions(const BenchmarkSamples& samples, const char* baselinePath, f32 threshold);
+
+/**
+ * Writes one row per run: the parameter value followed by the average, p50 and p95 of every
+ * metric. The runs and values are in the same order.
+ */
+bool WriteScalingCsv(const char* filepath, const char* parameter, const std::vector<u32>& values, const std::vector<BenchmarkSamples>& runs);
+
+/**
+ * Runs the benchmark on an offscreen context (RunHeadless). Returns 0 on success, 1 when a
+ * baseline was given and the run regressed, -1 if it could not run. The measured samples are
+ * copied to samples when given.
+ */
+int RunBenchmark(App* app, const BenchmarkOptions& options, BenchmarkSamples* samples = NULL);
@@ -26,6 +26,126 @@ Buffer CreateBuffer(u32 size, GLenum type, GLenum usage)
     return buffer;
 }
 
+Buffer CreateRingBuffer(u32 regionSize, GLenum type)
+{
+    Buffer buffer = {};
+    buffer.size = regionSize * BUFFER_RING_REGIONS;
+    buffer.type = type;
+    buffer.regionSize = regionSize;
+    buffer.regionIdx = BUFFER_RING_REGIONS - 1; //The first MapRingRegion moves to region 0
+
+    glGenBuffers(1, &buffer.handle);
+    glBindBuffer(type, buffer.handle);
+    if (GLAD_GL_ARB_buffer_storage)
+    {
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(type, buffer.size, NULL, flags);
+        buffer.data = glMapBufferRange(type, 0, buffer.size, flags);
+        buffer.isPersistent = buffer.data != NULL;
+    }
+    else
+    {
+        glBufferData(type, buffer.size, NULL, GL_DYNAMIC_DRAW);
+    }
+    glBindBuffer(type, 0);
+
+    return buffer;
+}
+
+void MapRingRegion(Buffer& buffer)
+{
+    ASSERT(buffer.regionSize > 0, "Not a ring buffer");
+    buffer.regionIdx = (buffer.regionIdx + 1) % BUFFER_RING_REGIONS;
+
+    GLsync& fence = buffer.regionFences[buffer.regionIdx];
+    if (fence)
+    {
+        //Normally signalled long ago, this only blocks when the GPU is frames behind
+        GLenum result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+        while (result == GL_TIMEOUT_EXPIRED)
+            result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+        glDeleteSync(fence);
+        fence = 0;
+    }
+
+    if (!buffer.isPersistent)
+    {
+        glBindBuffer(buffer.type, buffer.handle);
+        buffer.data = glMapBufferRange(buffer.type, 0, buffer.size, GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+        glBindBuffer(buffer.type, 0);
+    }
+    buffer.head = buffer.regionIdx * buffer.regionSize;
+}
+
+void UnmapRingRegion(Buffer& buffer)
+{
+    if (buffer.isPersistent)
+        return;
+
+    glBindBuffer(buffer.type, buffer.handle);
+    glUnmapBuffer(buffer.type);
+    glBindBuffer(buffer.type, 0);
+    buffer.data = NULL;
+}
+
+void FenceRingRegion(Buffer& buffer)
+{
+    ASSERT(buffer.regionFences[buffer.regionIdx] == 0, "The region is already fenced");
+    buffer.regionFences[buffer.regionIdx] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+void CreateUniformAllocator(UniformAllocator& allocator, u32 regionSize, u32 alignment, GLenum type)
+{
+    ASSERT(IsPowerOf2(alignment), "The alignment must be a power of 2");
+    allocator.regionSize = Align(regionSize, alignment);
+    allocator.alignment = alignment;
+    allocator.type = type;
+    allocator.usedBlockCount = 0;
+    allocator.blocks.clear();
+    allocator.blocks.push_back(CreateRingBuffer(allocator.regionSize, allocator.type));
+}
+
+void BeginUniformWrites(UniformAllocator& allocator)
+{
+    ASSERT(allocator.usedBlockCount == 0, "The previous frame's writes were not ended");
+    MapRingRegion(allocator.blocks[0]);
+    allocator.usedBlockCount = 1;
+}
+
+Buffer& ReserveUniforms(UniformAllocator& allocator, u32 size)
+{
+    ASSERT(allocator.usedBlockCount > 0, "BeginUniformWrites must be called first");
+    ASSERT(size <= allocator.regionSize, "The data does not fit in a single block");
+
+    Buffer* block = &allocator.blocks[allocator.usedBlockCount - 1];
+    AlignHead(*block, allocator.alignment);
+    if (block->head + size > (block->regionIdx + 1) * block->regionSize)
+    {
+        if (allocator.usedBlockCount == allocator.blocks.size())
+        {
+            allocator.blocks.push_back(CreateRingBuffer(allocator.regionSize, allocator.type));
+            ILOG("Uniform allocator grown to %u blocks of %u bytes", (u32)allocator.blocks.size(), allocator.regionSize);
+        }
+
+        block = &allocator.blocks[allocator.usedBlockCount++];
+        MapRingRegion(*block);
+    }
+    return *block;
+}
+
+void EndUniformWrites(UniformAllocator& allocator)
+{
+    for (u32 i = 0; i < allocator.usedBlockCount; ++i)
+        UnmapRingRegion(allocator.blocks[i]);
+}
+
+void FenceUniformWrites(UniformAllocator& allocator)
+{
+    for (u32 i = 0; i < allocator.usedBlockCount; ++i)
+        FenceRingRegion(allocator.blocks[i]);
+    allocator.usedBlockCount = 0;
+}
+
 void BindBuffer(const Buffer& buffer)
 {
     glBindBuffer(buffer.type, buffer.handle);
@@ -54,6 +174,7 @@ void PushAlignedData(Buffer& buffer, const void* data, u32 size, u32 alignment)
 {
     ASSERT(buffer.data != NULL, "The buffer must be mapped first");
     AlignHead(buffer, alignment);
+    ASSERT(buffer.regionSize == 0 || buffer.head + size <= (buffer.regionIdx + 1) * buffer.regionSize, "Ring buffer region overflow");
     memcpy((u8*)buffer.data + buffer.head, data, size);
     buffer.head += size;
 }
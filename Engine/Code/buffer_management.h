@@ -4,6 +4,7 @@
 #include <iostream>
 
 struct Buffer;
+struct UniformAllocator;
 
 bool IsPowerOf2(u32 value);
 u32 Align(u32 value, u32 alignment);
@@ -13,6 +14,55 @@ Buffer CreateBuffer(u32 size, GLenum type, GLenum usage);
 #define CreateStaticVertexBuffer(size) CreateBuffer(size, GL_ARRAY_BUFFER, GL_STATIC_DRAW)
 #define CreateStaticIndexBuffer(size) CreateBuffer(size, GL_ELEMENT_ARRAY_BUFFER, GL_STATIC_DRAW)
 
+/**
+ * Creates a buffer of BUFFER_RING_REGIONS regions of regionSize bytes, written one region
+ * per frame. With GL_ARB_buffer_storage it is mapped once, persistently and coherently;
+ * otherwise every MapRingRegion maps it unsynchronized, the fences keeping that safe.
+ */
+Buffer CreateRingBuffer(u32 regionSize, GLenum type);
+
+#define CreateConstantRingBuffer(regionSize) CreateRingBuffer(regionSize, GL_UNIFORM_BUFFER)
+
+/**
+ * Moves to the next region, waiting for the GPU only if it still reads it from
+ * BUFFER_RING_REGIONS frames ago, and points the head at its start.
+ */
+void MapRingRegion(Buffer& buffer);
+void UnmapRingRegion(Buffer& buffer);
+
+/**
+ * Fences the current region once the commands reading it have been issued.
+ */
+void FenceRingRegion(Buffer& buffer);
+
+/**
+ * Sets up an allocator whose blocks are ring buffers of the given type (uniform or shader
+ * storage) with regionSize bytes per region. The first block is created right away, the
+ * rest on demand.
+ */
+void CreateUniformAllocator(UniformAllocator& allocator, u32 regionSize, u32 alignment, GLenum type);
+
+/**
+ * Maps the next region of the first block. Blocks after it are only mapped once the frame
+ * reaches them.
+ */
+void BeginUniformWrites(UniformAllocator& allocator);
+
+/**
+ * Returns the block the next size bytes go to, its head already aligned. When they do not
+ * fit in what is left of the current block's region, the next block is mapped (and created
+ * if no frame needed it before) instead of overflowing. Push the data right away: the
+ * returned reference is invalidated by the next call.
+ */
+Buffer& ReserveUniforms(UniformAllocator& allocator, u32 size);
+
+void EndUniformWrites(UniformAllocator& allocator);
+
+/**
+ * Fences the regions written this frame, see FenceRingRegion.
+ */
+void FenceUniformWrites(UniformAllocator& allocator);
+
 void BindBuffer(const Buffer& buffer);
 void MapBuffer(Buffer& buffer, GLenum access);
 void UnmapBuffer(Buffer& buffer);
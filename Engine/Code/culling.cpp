@@ -0,0 +1,156 @@
+#include "culling.h"
+#include "engine.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CULLING_USE_SSE 1
+#include <emmintrin.h>
+#endif
+
+AABB TransformAABB(const AABB& box, const glm::mat4& transform)
+{
+    glm::vec3 center = (box.min + box.max) * 0.5f;
+    glm::vec3 extent = (box.max - box.min) * 0.5f;
+
+    glm::vec3 worldCenter = glm::vec3(transform * glm::vec4(center, 1.0f));
+    glm::vec3 worldExtent = glm::vec3(0.0f);
+    for (u32 column = 0; column < 3; ++column)
+        worldExtent += glm::abs(glm::vec3(transform[column])) * extent[column];
+
+    AABB result;
+    result.min = worldCenter - worldExtent;
+    result.max = worldCenter + worldExtent;
+    return result;
+}
+
+void UpdateCullingBounds(App* app)
+{
+    CullingBounds& bounds = app->cullingBounds;
+    bounds = CullingBounds();
+
+    EntityStore& entities = app->entities;
+    for (u32 i = 0; i < entities.count; ++i)
+    {
+        const Model& model = app->models[entities.modelIndices[i]];
+        const Mesh& mesh = app->meshes[model.meshIdx];
+
+        entities.firstBoundsIndices[i] = bounds.count;
+        for (const Submesh& submesh : mesh.submeshes)
+        {
+            AABB worldBounds = TransformAABB(submesh.bounds, entities.worldMatrices[i]);
+            glm::vec3 center = (worldBounds.min + worldBounds.max) * 0.5f;
+            glm::vec3 extent = (worldBounds.max - worldBounds.min) * 0.5f;
+
+            bounds.centerX.push_back(center.x);
+            bounds.centerY.push_back(center.y);
+            bounds.centerZ.push_back(center.z);
+            bounds.extentX.push_back(extent.x);
+            bounds.extentY.push_back(extent.y);
+            bounds.extentZ.push_back(extent.z);
+            ++bounds.count;
+        }
+    }
+
+    //The padding is tested too, its results are never read
+    u32 paddedCount = (bounds.count + 3u) & ~3u;
+    bounds.centerX.resize(paddedCount, 0.0f);
+    bounds.centerY.resize(paddedCount, 0.0f);
+    bounds.centerZ.resize(paddedCount, 0.0f);
+    bounds.extentX.resize(paddedCount, 0.0f);
+    bounds.extentY.resize(paddedCount, 0.0f);
+    bounds.extentZ.resize(paddedCount, 0.0f);
+    bounds.isVisible.resize(paddedCount, 0);
+}
+
+//Gribb & Hartmann: the planes come from the rows of the view projection matrix and point
+//inwards. They are left unnormalized since only the sign of the distances matters.
+void ExtractFrustumPlanes(const glm::mat4& viewProjection, glm::vec4* planes)
+{
+    glm::mat4 rows = glm::transpose(viewProjection);
+    planes[0] = rows[3] + rows[0]; //Left
+    planes[1] = rows[3] - rows[0]; //Right
+    planes[2] = rows[3] + rows[1]; //Bottom
+    planes[3] = rows[3] - rows[1]; //Top
+    planes[4] = rows[3] + rows[2]; //Near
+    planes[5] = rows[3] - rows[2]; //Far
+}
+
+//A box is outside if it lies fully behind any plane: distance of its center plus its
+//projected radius is negative
+void TestBoundsAgainstFrustum(CullingBounds& bounds, const glm::vec4* planes)
+{
+    const u32 paddedCount = (u32)bounds.isVisible.size();
+
+#ifdef CULLING_USE_SSE
+    for (u32 i = 0; i < paddedCount; i += 4)
+    {
+        __m128 centerX = _mm_loadu_ps(&bounds.centerX[i]);
+        __m128 centerY = _mm_loadu_ps(&bounds.centerY[i]);
+        __m128 centerZ = _mm_loadu_ps(&bounds.centerZ[i]);
+        __m128 extentX = _mm_loadu_ps(&bounds.extentX[i]);
+        __m128 extentY = _mm_loadu_ps(&bounds.extentY[i]);
+        __m128 extentZ = _mm_loadu_ps(&bounds.extentZ[i]);
+        __m128 outside = _mm_setzero_ps();
+
+        for (u32 p = 0; p < 6; ++p)
+        {
+            const glm::vec4& plane = planes[p];
+            __m128 distance = _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(centerX, _mm_set1_ps(plane.x)), _mm_mul_ps(centerY, _mm_set1_ps(plane.y))),
+                _mm_add_ps(_mm_mul_ps(centerZ, _mm_set1_ps(plane.z)), _mm_set1_ps(plane.w)));
+            __m128 radius = _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(extentX, _mm_set1_ps(fabsf(plane.x))), _mm_mul_ps(extentY, _mm_set1_ps(fabsf(plane.y)))),
+                _mm_mul_ps(extentZ, _mm_set1_ps(fabsf(plane.z))));
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(distance, radius), _mm_setzero_ps()));
+        }
+
+        int outsideMask = _mm_movemask_ps(outside);
+        for (u32 lane = 0; lane < 4; ++lane)
+            bounds.isVisible[i + lane] = ((outsideMask >> lane) & 1) == 0;
+    }
+#else
+    for (u32 i = 0; i < paddedCount; ++i)
+    {
+        bool isOutside = false;
+        for (u32 p = 0; p < 6 && !isOutside; ++p)
+        {
+            const glm::vec4& plane = planes[p];
+            f32 distance = bounds.centerX[i] * plane.x + bounds.centerY[i] * plane.y + bounds.centerZ[i] * plane.z + plane.w;
+            f32 radius = bounds.extentX[i] * fabsf(plane.x) + bounds.extentY[i] * fabsf(plane.y) + bounds.extentZ[i] * fabsf(plane.z);
+            isOutside = distance + radius < 0.0f;
+        }
+        bounds.isVisible[i] = !isOutside;
+    }
+#endif
+}
+
+void CullEntities(App* app)
+{
+    PROFILE_SCOPE("CullEntities");
+
+    glm::vec4 planes[6];
+    ExtractFrustumPlanes(app->camera.projection * app->camera.view, planes);
+
+    CullingBounds& bounds = app->cullingBounds;
+    TestBoundsAgainstFrustum(bounds, planes);
+
+    CullingStats stats;
+    EntityStore& entities = app->entities;
+    for (u32 i = 0; i < entities.count; ++i)
+    {
+        const Model& model = app->models[entities.modelIndices[i]];
+        u32 submeshCount = (u32)app->meshes[model.meshIdx].submeshes.size();
+
+        u32 visibleSubmeshes = 0;
+        for (u32 j = 0; j < submeshCount; ++j)
+            visibleSubmeshes += bounds.isVisible[entities.firstBoundsIndices[i] + j];
+
+        entities.isVisible[i] = visibleSubmeshes > 0;
+        stats.visibleSubmeshes += visibleSubmeshes;
+        stats.culledSubmeshes += submeshCount - visibleSubmeshes;
+        if (entities.isVisible[i])
+            ++stats.visibleEntities;
+        else
+            ++stats.culledEntities;
+    }
+    app->cullingStats = stats;
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "platform.h"
+
+//Frustum culling of entity submeshes. Every submesh of every entity has a world space AABB,
+//computed when the entities are set up and kept as centers/extents in SoA arrays so the
+//frustum test runs on four boxes at a time with SSE.
+
+struct App;
+
+struct AABB
+{
+    glm::vec3 min = glm::vec3(0.0f);
+    glm::vec3 max = glm::vec3(0.0f);
+};
+
+struct CullingBounds
+{
+    //Every vector, isVisible included, is padded to a multiple of 4 with zero sized boxes at
+    //the origin. They are tested with the rest but their results are never read
+    std::vector<f32> centerX, centerY, centerZ;
+    std::vector<f32> extentX, extentY, extentZ;
+    std::vector<u8> isVisible;
+    u32 count = 0; //Real number of boxes, without the padding
+};
+
+struct CullingStats
+{
+    u32 visibleEntities = 0;
+    u32 culledEntities = 0;
+    u32 visibleSubmeshes = 0;
+    u32 culledSubmeshes = 0;
+};
+
+/**
+ * Bounds of an AABB once transformed by the given matrix.
+ */
+AABB TransformAABB(const AABB& box, const glm::mat4& transform);
+
+/**
+ * Frustum planes of a view projection matrix, pointing inwards, in the order left, right,
+ * bottom, top, near, far. They are not normalized.
+ */
+void ExtractFrustumPlanes(const glm::mat4& viewProjection, glm::vec4* planes);
+
+/**
+ * Flags the boxes that are not fully behind any of the six planes, padding included.
+ */
+void TestBoundsAgainstFrustum(CullingBounds& bounds, const glm::vec4* planes);
+
+/**
+ * Recomputes the world space bounds of every entity submesh. Call it after adding entities
+ * or changing their world matrix.
+ */
+void UpdateCullingBounds(App* app);
+
+/**
+ * Tests every entity submesh against the camera frustum and flags the entities and
+ * submeshes that have to be drawn this frame. Runs between the camera update and the
+ * uniform packing.
+ */
+void CullEntities(App* app);
@@ -3,8 +3,10 @@
 #include <stb_image.h>
 #include <stb_image_write.h>
 #include <iostream>
+#include <unordered_set>
 
 #define BINDING(b) b
+#define GLSL_VERSION_STRING "#version 430\n"
 
 GLuint CreateProgramFromSource(String programSource, const char* shaderName)
 {
@@ -13,7 +15,7 @@ GLuint CreateProgramFromSource(String programSource, const char* shaderName)
     GLsizei infoLogSize;
     GLint   success;
 
-    char versionString[] = "#version 430\n";
+    char versionString[] = GLSL_VERSION_STRING;
     char shaderNameDefine[128];
     sprintf(shaderNameDefine, "#define %s\n", shaderName);
     char vertexShaderDefine[] = "#define VERTEX\n";
@@ -67,6 +69,7 @@ GLuint CreateProgramFromSource(String programSource, const char* shaderName)
     GLuint programHandle = glCreateProgram();
     glAttachShader(programHandle, vshader);
     glAttachShader(programHandle, fshader);
+    glProgramParameteri(programHandle, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE); //For the program cache
     glLinkProgram(programHandle);
     glGetProgramiv(programHandle, GL_LINK_STATUS, &success);
     if (!success)
@@ -85,12 +88,28 @@ GLuint CreateProgramFromSource(String programSource, const char* shaderName)
     return programHandle;
 }
 
+GLint GetUniformLocation(const Program& program, const char* name)
+{
+    auto it = program.uniformLocations.find(name);
+    return it != program.uniformLocations.end() ? it->second : -1;
+}
+
 u32 LoadProgram(App* app, const char* filepath, const char* programName)
 {
     String programSource = ReadTextFile(filepath);
 
+    //The preamble CreateProgramFromSource puts before the source of both stages
+    char preamble[160];
+    snprintf(preamble, sizeof(preamble), GLSL_VERSION_STRING "#define %s\n", programName);
+    u64 cacheKey = ComputeProgramCacheKey(programSource, preamble);
+
     Program program = Program();
-    program.handle = CreateProgramFromSource(programSource, programName);
+    program.handle = LoadProgramFromCache(filepath, programName, cacheKey);
+    if (!program.handle)
+    {
+        program.handle = CreateProgramFromSource(programSource, programName);
+        SaveProgramToCache(filepath, programName, cacheKey, program.handle);
+    }
     program.filepath = filepath;
     program.programName = programName;
     program.lastWriteTimestamp = GetFileLastWriteTimestamp(filepath);
@@ -110,7 +129,10 @@ u32 LoadProgram(App* app, const char* filepath, const char* programName)
         int attributeSize = 0;
         GLenum attributeType;
         glGetActiveAttrib(program.handle, i, attributeNameMaxLength + 1, &attributeNameLength, &attributeSize, &attributeType, attributeName);
-        u8 attributeLocation = glGetAttribLocation(program.handle, attributeName);
+        GLint location = glGetAttribLocation(program.handle, attributeName);
+        if (location < 0)
+            continue; //Built-in inputs such as gl_InstanceID are not fed by vertex buffers
+        u8 attributeLocation = (u8)location;
 
         u8 componentCount = 1;
         switch (attributeType)
@@ -133,6 +155,32 @@ u32 LoadProgram(App* app, const char* filepath, const char* programName)
         program.vertexInputLayout.attributes.push_back(VertexBufferAttribute(attributeLocation,componentCount,0));
     }
     delete[] attributeName;
+
+    //Uniform locations, so drawing never looks them up by name
+    int uniformCount = 0;
+    int uniformNameMaxLength = 0;
+    glGetProgramiv(program.handle, GL_ACTIVE_UNIFORMS, &uniformCount);
+    glGetProgramiv(program.handle, GL_ACTIVE_UNIFORM_MAX_LENGTH, &uniformNameMaxLength);
+
+    std::vector<char> uniformName(uniformNameMaxLength + 1);
+    for (int i = 0; i < uniformCount; ++i)
+    {
+        int uniformNameLength = 0;
+        int uniformSize = 0;
+        GLenum uniformType;
+        glGetActiveUniform(program.handle, i, (GLsizei)uniformName.size(), &uniformNameLength, &uniformSize, &uniformType, uniformName.data());
+
+        //Members of uniform blocks have no location
+        GLint location = glGetUniformLocation(program.handle, uniformName.data());
+        if (location < 0)
+            continue;
+
+        std::string name(uniformName.data(), uniformNameLength);
+        program.uniformLocations[name] = location;
+        if (name.size() > 3 && name.compare(name.size() - 3, 3, "[0]") == 0)
+            program.uniformLocations[name.substr(0, name.size() - 3)] = location;
+    }
+
     app->programs.push_back(program);
     return app->programs.size() - 1;
 }
@@ -140,7 +188,8 @@ u32 LoadProgram(App* app, const char* filepath, const char* programName)
 Image LoadImage(const char* filename)
 {
     Image img = {};
-    stbi_set_flip_vertically_on_load(true);
+    //Per-thread flag: images may be decoded concurrently by LoadTextures2D workers
+    stbi_set_flip_vertically_on_load_thread(true);
     img.pixels = stbi_load(filename, &img.size.x, &img.size.y, &img.nchannels, 0);
     if (img.pixels)
     {
@@ -188,24 +237,69 @@ GLuint CreateTexture2DFromImage(Image image)
 
 u32 LoadTexture2D(App* app, const char* filepath)
 {
-    for (u32 texIdx = 0; texIdx < app->textures.size(); ++texIdx)
-        if (app->textures[texIdx].filepath == filepath)
-            return texIdx;
+    u32 texIdx = UINT32_MAX;
+    LoadTextures2D(app, &filepath, 1, &texIdx);
+    return texIdx;
+}
+
+void LoadTextures2D(App* app, const char* const* filepaths, u32 count, u32* textureIndices)
+{
+    PROFILE_SCOPE("LoadTextures2D");
 
-    Image image = LoadImage(filepath);
-    if (image.pixels)
+    //--Gather the files that still have to be decoded, each one once--
+    std::vector<u32> decodeList;
+    std::unordered_set<u64> queuedPaths;
+    for (u32 i = 0; i < count; ++i)
     {
-        Texture tex = {};
-        tex.handle = CreateTexture2DFromImage(image);
-        tex.filepath = filepath;
+        textureIndices[i] = FindTexture2D(app, filepaths[i]);
+        if (textureIndices[i] == UINT32_MAX && queuedPaths.insert(HashResourcePath(filepaths[i])).second)
+            decodeList.push_back(i);
+    }
 
-        u32 texIdx = app->textures.size();
-        app->textures.push_back(tex);
+    if (decodeList.empty())
+        return;
 
-        FreeImage(image);
-        return texIdx;
+    //--Decode in parallel, the jobs only touch the CPU side--
+    //Baked textures are only mapped here, their mips are ready to upload
+    std::vector<Image> images(decodeList.size());
+    std::vector<BakedTexture> bakedTextures(decodeList.size());
+    ParallelFor(app->jobs, (u32)decodeList.size(), 1, [&](u32 begin, u32 end)
+    {
+        for (u32 i = begin; i < end; ++i)
+        {
+            PROFILE_SCOPE("DecodeTexture");
+            const char* filepath = filepaths[decodeList[i]];
+            if (!LoadBakedTexture(filepath, bakedTextures[i]))
+                images[i] = LoadImage(filepath);
+        }
+    });
+
+    //--Upload on the GL thread--
+    for (u32 i = 0; i < decodeList.size(); ++i)
+    {
+        Texture tex = {};
+        if (bakedTextures[i].file.data)
+        {
+            tex.handle = CreateTexture2DFromBaked(bakedTextures[i]);
+            FreeBakedTexture(bakedTextures[i]);
+        }
+        else if (images[i].pixels)
+        {
+            tex.handle = CreateTexture2DFromImage(images[i]);
+            FreeImage(images[i]);
+        }
+        else
+        {
+            continue;
+        }
+
+        tex.filepath = filepaths[decodeList[i]];
+        AddTexture2D(app, tex);
     }
-    return UINT32_MAX;
+
+    for (u32 i = 0; i < count; ++i)
+        if (textureIndices[i] == UINT32_MAX)
+            textureIndices[i] = FindTexture2D(app, filepaths[i]);
 }
 
 u32 CreateTextureQuad(App* app)
@@ -263,37 +357,6 @@ void CreateTextureQuadGeometry(App* app, Material myMaterial)
     };
 
     Submesh submesh = Submesh();
-    for (int i = 0; i < 6; ++i)
-        submesh.indices.push_back(indices[i]);
-
-    for (int i = 0; i < 20; ++i)
-        submesh.vertices.push_back(vertices[i]);
-
-    Mesh mesh = Mesh();
-    glGenBuffers(1, &mesh.vertexBufferHandle);
-    glBindBuffer(GL_ARRAY_BUFFER, mesh.vertexBufferHandle);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-    glGenBuffers(1, &mesh.indexBufferHandle);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.indexBufferHandle);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-
-    GLuint vao = 0;
-    glGenVertexArrays(1, &vao);
-    glBindVertexArray(vao);
-    glBindBuffer(GL_ARRAY_BUFFER, mesh.vertexBufferHandle);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(submesh.vertices), (void*)0);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(submesh.vertices), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(submesh.vertices), (void*)(6 * sizeof(float)));
-    glEnableVertexAttribArray(2);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.indexBufferHandle);
-    glBindVertexArray(0);
-
-    submesh.vaos.push_back(VAO{ vao,app->programs[app->texturedMeshProgramIdx].handle });
 
     //Create the vertex format
     VertexBufferLayout vertexBufferLayout = VertexBufferLayout();
@@ -304,77 +367,58 @@ void CreateTextureQuadGeometry(App* app, Material myMaterial)
     vertexBufferLayout.attributes.push_back(VertexBufferAttribute( 2, 2, vertexBufferLayout.stride ));
     vertexBufferLayout.stride += 2 * sizeof(float);
     submesh.vertexBufferLayout = vertexBufferLayout;
-    submesh.vertexOffset = 0;
-    submesh.indexOffset = 0;
 
-    app->materials.push_back(myMaterial);
+    MeshArenaAllocation allocation = UploadToMeshArena(app, vertexBufferLayout, vertices, sizeof(vertices), indices, sizeof(indices));
+    submesh.arenaIdx = allocation.arenaIdx;
+    submesh.baseVertex = allocation.baseVertex;
+    submesh.firstIndex = allocation.firstIndex;
+    submesh.indexCount = ARRAY_COUNT(indices);
+    submesh.bounds.min = vec3(-0.5f, -0.5f, 0.0f);
+    submesh.bounds.max = vec3(0.5f, 0.5f, 0.0f);
+
+    Mesh mesh = Mesh();
     mesh.submeshes.push_back(submesh);
     app->meshes.push_back(mesh);
     Model model = Model();
-    model.materialIdx.push_back(app->materials.size() - 1u);
+    model.materialIdx.push_back(AddMaterial(app, myMaterial));
     model.meshIdx = (u32)app->meshes.size() - 1u;
     app->models.push_back(model);
     app->planeModelIdx = (u32)app->models.size() - 1u;
-
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
 }
 
-GLuint FindVAO(Mesh& mesh, u32 submeshIndex, const Program& program)
+static void CreateBuiltInScene(App* app)
 {
-    Submesh& submesh = mesh.submeshes[submeshIndex];
-
-    //Try finding a VAO for this submesh/program
-    for (u32 i = 0; i < (u32)submesh.vaos.size(); ++i)
-    {
-        if (submesh.vaos[i].programHandle == program.handle)
-            return submesh.vaos[i].handle;
-    }
-
-    GLuint vaoHandle = 0;
-    //Create a new VAO for this submesh/program
-    {
-        glGenVertexArrays(1, &vaoHandle);
-        glBindVertexArray(vaoHandle);
-
-        glBindBuffer(GL_ARRAY_BUFFER, mesh.vertexBufferHandle);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.indexBufferHandle);
-
-        //We have to link all vertex inputs attributes to attributes in the vertex buffer
-        for (u32 i = 0; i < program.vertexInputLayout.attributes.size(); ++i)
-        {
-            bool attributeWasLinked = false;
-
-            for (u32 j = 0; j < submesh.vertexBufferLayout.attributes.size(); ++j)
-            {
-                //The submesh should provide an attribute for each vertex inputs
-                if (program.vertexInputLayout.attributes[i].location == submesh.vertexBufferLayout.attributes[j].location)
-                {
-                    const u32 index = submesh.vertexBufferLayout.attributes[j].location;
-                    const u32 ncomp = submesh.vertexBufferLayout.attributes[j].componentCount;
-                    const u32 offset = submesh.vertexBufferLayout.attributes[j].offset + submesh.vertexOffset;
-                    const u32 stride = submesh.vertexBufferLayout.stride;
-                    glVertexAttribPointer(index, ncomp, GL_FLOAT, GL_FALSE, stride, (void*)(u64)offset);
-                    glEnableVertexAttribArray(index);
-
-                    attributeWasLinked = true;
-                    break;
-                }
-            }
-            assert(attributeWasLinked);
-        }
-        glBindVertexArray(0);
-    }
-
-    //Store it in the list of vaos for this submesh
-    VAO vao = { vaoHandle,program.handle };
-    submesh.vaos.push_back(vao);
+    //Entities
+    glm::mat4 p1 = glm::translate(glm::mat4(1.0f), vec3(-1.0f, 0.0f, -3.0f));
+    AddEntity(app->entities, p1, app->patrickModelIdx);
+    glm::mat4 p2 = glm::translate(glm::mat4(1.0f), vec3(10.0f, 5.0f, 0.0f));
+    p2 = glm::rotate(p2, glm::radians(-60.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    AddEntity(app->entities, p2, app->patrickModelIdx);
+
+    glm::mat4 plane = glm::translate(glm::mat4(1.0f), vec3(-0.5f, -3.5f, -0.5f));
+    plane = glm::rotate(plane, glm::radians(-90.0f), glm::vec3(1.0f, .0f, 0.0f));
+    plane = glm::scale(plane, vec3(40.0f));
+    AddEntity(app->entities, plane, app->planeModelIdx);
+    UpdateCullingBounds(app);
 
-    return vaoHandle;
+    //Lights
+    Light l1(LightType::Directional_Light, vec3(0.0f), vec3(-0.2f, -1.0f, -0.35f), vec3(0.0f,0.0f,0.4f), vec3(0.25f), vec3(0.5f));
+    app->lights.push_back(l1);
+    Light l2(LightType::Point_Light, vec3(-4.0f, 1.5f, -5.0f), vec3(0.0f), vec3(1.0f,0.0f,0.0f), vec3(0.5f), vec3(1.0f),0.005f);
+    app->lights.push_back(l2);
+    Light l3(LightType::Point_Light, vec3(4.0f, 2.0f, -6.0f), vec3(0.0f), vec3(0.0f,1.0f,0.0f), vec3(0.5f), vec3(1.0f), 0.005f);
+    app->lights.push_back(l3);
+    Light l4(LightType::Point_Light, vec3(-0.5f, 0.5f, 6.0f), vec3(0.0f), vec3(0.05f, 0.05f, 0.0f), vec3(0.5f), vec3(1.0f));
+    app->lights.push_back(l4);
+    Light l5(LightType::Point_Light, vec3(6.5f, 6.5f, 4.5f), vec3(0.0f), vec3(1.0f), vec3(0.5f), vec3(1.0f), 0.01f);
+    app->lights.push_back(l5);
 }
 
 void Init(App* app)
 {
+    SetProfilerThreadName("Main thread");
+    PROFILE_SCOPE("Init");
+
     InfoInit(app);
 
     glEnable(GL_BLEND);
@@ -383,6 +427,9 @@ void Init(App* app)
 
     DebugInit();
 
+    //Jobs: every spare hardware thread, the main thread joins in while it waits
+    CreateJobSystem(app->jobs, GetDefaultWorkerCount());
+
     app->renderTargets.push_back("final color");
     app->renderTargets.push_back("position color");
     app->renderTargets.push_back("normal color");
@@ -394,11 +441,15 @@ void Init(App* app)
     FrameBufferInit(app);
 
     //Texture initialization
-    app->diceTexIdx = LoadTexture2D(app, "dice.png");
-    app->whiteTexIdx = LoadTexture2D(app, "color_white.png");
-    app->blackTexIdx = LoadTexture2D(app, "color_black.png");
-    app->normalTexIdx = LoadTexture2D(app, "color_normal.png");
-    app->magentaTexIdx = LoadTexture2D(app, "color_magenta.png");
+    const char* texturePaths[] = { "dice.png", "color_white.png", "color_black.png", "color_normal.png", "color_magenta.png" };
+    u32 textureIndices[ARRAY_COUNT(texturePaths)];
+    LoadTextures2D(app, texturePaths, ARRAY_COUNT(texturePaths), textureIndices);
+    app->diceTexIdx = textureIndices[0];
+    app->whiteTexIdx = textureIndices[1];
+    app->blackTexIdx = textureIndices[2];
+    app->normalTexIdx = textureIndices[3];
+    app->magentaTexIdx = textureIndices[4];
+    InitTextureStreamer(app->textureStreamer, app->jobs);
 
     //Materials
     Material planeMat = Material("plane_mat", vec3(1.0f), vec3(0.0f), vec3(0.5f), 64.0f, app->whiteTexIdx);
@@ -406,7 +457,7 @@ void Init(App* app)
     //Patrick
     app->patrickModelIdx = LoadModel(app, "Patrick/Patrick.obj");
     app->texturedMeshProgramIdx = LoadProgram(app, "shaders.glsl", "GEOMETRY_PASS");
-    app->programUniformDiffuse = glGetUniformLocation(app->programs[app->texturedMeshProgramIdx].handle, "material.diffuse");
+    app->programUniformDiffuse = GetUniformLocation(app->programs[app->texturedMeshProgramIdx], "material.diffuse");
 
     //TextQuadGeometry
     CreateTextureQuadGeometry(app, planeMat);
@@ -414,56 +465,43 @@ void Init(App* app)
     //TextQuad
     app->vaoIdx = CreateTextureQuad(app);
     app->texturedQuadProgramIdx = LoadProgram(app, "shaders.glsl", "LIGHTING_PASS");
-    app->programUniformRenderTarget = glGetUniformLocation(app->programs[app->texturedQuadProgramIdx].handle, "renderTarget");
-    app->programUniformLightingPosition = glGetUniformLocation(app->programs[app->texturedQuadProgramIdx].handle, "gPosition");
-    app->programUniformLightingNormal = glGetUniformLocation(app->programs[app->texturedQuadProgramIdx].handle, "gNormal");
-    app->programUniformLightingAlbedo = glGetUniformLocation(app->programs[app->texturedQuadProgramIdx].handle, "gAlbedo");
-    app->programUniformLightingSpec = glGetUniformLocation(app->programs[app->texturedQuadProgramIdx].handle, "gSpec");
-    app->programUniformLightingDepth = glGetUniformLocation(app->programs[app->texturedQuadProgramIdx].handle, "gDepth");
+    app->programUniformRenderTarget = GetUniformLocation(app->programs[app->texturedQuadProgramIdx], "renderTarget");
+    app->programUniformLightingPosition = GetUniformLocation(app->programs[app->texturedQuadProgramIdx], "gPosition");
+    app->programUniformLightingNormal = GetUniformLocation(app->programs[app->texturedQuadProgramIdx], "gNormal");
+    app->programUniformLightingAlbedo = GetUniformLocation(app->programs[app->texturedQuadProgramIdx], "gAlbedo");
+    app->programUniformLightingSpec = GetUniformLocation(app->programs[app->texturedQuadProgramIdx], "gSpec");
+    app->programUniformLightingDepth = GetUniformLocation(app->programs[app->texturedQuadProgramIdx], "gDepth");
     app->postProcessingProgramIdx = LoadProgram(app, "shaders.glsl", "POST_PROCESSING_PASS");
-    app->programUniformPostProcessing = glGetUniformLocation(app->programs[app->postProcessingProgramIdx].handle, "finalImage");
+    app->programUniformPostProcessing = GetUniformLocation(app->programs[app->postProcessingProgramIdx], "finalImage");
 
-    //Entities
-    Entity* p1 = new Entity(glm::mat4(1.0f), app->patrickModelIdx);
-    p1->worldMatrix = glm::translate(p1->worldMatrix, vec3(-1.0f, 0.0f, -3.0f));
-    app->entities.push_back(p1);
-    Entity* p2 = new Entity(glm::mat4(1.0f), app->patrickModelIdx);
-    p2->worldMatrix = glm::translate(p2->worldMatrix, vec3(10.0f, 5.0f, 0.0f));
-    p2->worldMatrix = glm::rotate(p2->worldMatrix, glm::radians(-60.0f), glm::vec3(0.0f, 1.0f, 0.0f));
-    app->entities.push_back(p2);
-
-    Entity* plane = new Entity(glm::mat4(1.0f), app->planeModelIdx);
-    plane->worldMatrix = glm::translate(plane->worldMatrix, vec3(-0.5f, -3.5f, -0.5f));
-    plane->worldMatrix = glm::rotate(plane->worldMatrix, glm::radians(-90.0f), glm::vec3(1.0f, .0f, 0.0f));
-    plane->worldMatrix = glm::scale(plane->worldMatrix, vec3(40.0f));
-    app->entities.push_back(plane);
-
-    //Lights
-    Light l1(LightType::Directional_Light, vec3(0.0f), vec3(-0.2f, -1.0f, -0.35f), vec3(0.0f,0.0f,0.4f), vec3(0.25f), vec3(0.5f));
-    app->lights.push_back(l1);
-    Light l2(LightType::Point_Light, vec3(-4.0f, 1.5f, -5.0f), vec3(0.0f), vec3(1.0f,0.0f,0.0f), vec3(0.5f), vec3(1.0f),0.005f);
-    app->lights.push_back(l2);
-    Light l3(LightType::Point_Light, vec3(4.0f, 2.0f, -6.0f), vec3(0.0f), vec3(0.0f,1.0f,0.0f), vec3(0.5f), vec3(1.0f), 0.005f);
-    app->lights.push_back(l3);
-    Light l4(LightType::Point_Light, vec3(-0.5f, 0.5f, 6.0f), vec3(0.0f), vec3(0.05f, 0.05f, 0.0f), vec3(0.5f), vec3(1.0f));
-    app->lights.push_back(l4);
-    Light l5(LightType::Point_Light, vec3(6.5f, 6.5f, 4.5f), vec3(0.0f), vec3(1.0f), vec3(0.5f), vec3(1.0f), 0.01f);
-    app->lights.push_back(l5);
+    //Entities and lights
+    if (!app->scene)
+        CreateBuiltInScene(app);
+    else if (!CreateScene(app, *app->scene))
+        app->isRunning = false;
 
     //Coordinate System / MVP Matrices
     app->camera.projection = glm::perspective(glm::radians(45.0f), (float)app->displaySize.x / app->displaySize.y, 0.1f, 100.0f);
 
-    //Creating buffer
-    glGetIntegerv(GL_MAX_UNIFORM_BLOCK_SIZE, &app->cbuffer.size);
+    //Creating buffers: one region per frame in flight so writing never waits on the GPU, and
+    //as many blocks as the entities need
+    glGetIntegerv(GL_MAX_UNIFORM_BLOCK_SIZE, &app->maxUniformBufferSize);
     glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &app->uniformBufferAlignment);
-
-    glGenBuffers(1, &app->cbuffer.handle);
-    glBindBuffer(GL_UNIFORM_BUFFER, app->cbuffer.handle);
-    glBufferData(GL_UNIFORM_BUFFER, app->cbuffer.size, NULL, GL_STREAM_DRAW);
-    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    //Regions can be larger than GL_MAX_UNIFORM_BLOCK_SIZE, only the bound ranges are limited by it
+    u32 uniformRegionSize = glm::max((u32)app->maxUniformBufferSize, (u32)UNIFORM_BLOCK_REGION_SIZE);
+    CreateUniformAllocator(app->uniforms, uniformRegionSize, app->uniformBufferAlignment, GL_UNIFORM_BUFFER);
+    InitInstancing(app);
+    CreateGpuTimers(app->gpuTimers);
     glViewport(0, 0, app->displaySize.x, app->displaySize.y);
 }
 
+void Shutdown(App* app)
+{
+    DestroyTextureStreamer(app->textureStreamer);
+    DestroyJobSystem(app->jobs);
+    DestroyGpuTimers(app->gpuTimers);
+}
+
 void InfoInit(App* app)
 {
     app->info.version = (char*)glGetString(GL_VERSION);
@@ -610,6 +648,8 @@ void FrameBufferCheck()
 
 void Gui(App* app)
 {
+    PROFILE_SCOPE("Gui");
+
     ImGuiWindowFlags windowFlags = ImGuiWindowFlags_NoDocking;
     ImGuiViewport* viewport = ImGui::GetMainViewport();
     ImGui::SetNextWindowViewport(viewport->ID);
@@ -649,6 +689,17 @@ void Gui(App* app)
     {
         ImGui::Begin("Info");
         ImGui::Text("FPS: %f", 1.0f / app->deltaTime);
+        if (ImGui::Button("Save CPU trace"))
+        {
+            if (SaveChromeTrace(CPU_TRACE_FILEPATH))
+            {
+                ILOG("CPU trace saved to %s", CPU_TRACE_FILEPATH);
+            }
+            else
+            {
+                ELOG("Could not save the CPU trace to %s", CPU_TRACE_FILEPATH);
+            }
+        }
         ImGui::Text("\n\n");
         ImGui::Text("Versions:");
         ImGui::BulletText(app->info.version.c_str());
@@ -667,7 +718,7 @@ void Gui(App* app)
         ImGui::Begin("Engine");
         if (ImGui::BeginCombo("Render Target", app->renderTargets[app->currentRenderTarget].c_str()))
         {
-            for (int i = 0; i < app->renderTargets.size(); ++i)
+            for (u32 i = 0; i < app->renderTargets.size(); ++i)
             {
                 bool is_selected = (app->renderTargets[app->currentRenderTarget] == app->renderTargets[i]);
                 if (ImGui::Selectable(app->renderTargets[i].c_str(), is_selected))
@@ -677,15 +728,49 @@ void Gui(App* app)
             }
             ImGui::EndCombo();
         }
+        const CullingStats& culling = app->cullingStats;
+        ImGui::Text("Entities: %u visible, %u culled", culling.visibleEntities, culling.culledEntities);
+        ImGui::Text("Submeshes: %u visible, %u culled", culling.visibleSubmeshes, culling.culledSubmeshes);
+        ImGui::Text("Streaming textures: %u", GetPendingTextureStreamCount(app->textureStreamer));
+        ImGui::Text("Textures: %u, materials: %u (%u reused)", (u32)app->textures.size(), (u32)app->materials.size(), app->registry.reusedMaterialCount);
+        ImGui::Text("Uniform blocks: %u of %u KB", (u32)app->uniforms.blocks.size(), app->uniforms.regionSize / 1024);
+        ImGui::Text("Multi-draws: %u for %u commands, %u instances", (u32)app->instancing.multiDraws.size(), (u32)app->instancing.draws.size(), app->instancing.instanceCount);
+        ImGui::Text("Mesh arenas: %u", (u32)app->meshArenas.size());
+        const RenderStateChanges& changes = app->instancing.stateChanges;
+        ImGui::Text("State changes: %u (%u unsorted)", changes.Total(), app->instancing.unsortedStateChanges.Total());
+        ImGui::Text("    %u programs, %u VAOs, %u textures, %u instance buffers", changes.programs, changes.vaos, changes.textures, changes.instanceBuffers);
+        ImGui::Text("GL state calls: %u issued, %u elided", app->glState.lastFrameIssuedCalls, app->glState.lastFrameElidedCalls);
+
+        //--Timings over the last GPU_TIMER_HISTORY_SIZE frames--
+        GpuTimers& timers = app->gpuTimers;
+        ImGui::Separator();
+        ImGui::Text("%-16s %8s %8s %8s", "ms", "min", "avg", "p99");
+        for (u32 pass = 0; pass < GpuTimerPass_Count; ++pass)
+        {
+            TimingStats stats = ComputeTimingStats(timers.passes[pass]);
+            ImGui::Text("%-16s %8.3f %8.3f %8.3f", GetGpuTimerPassName((GpuTimerPass)pass), stats.min, stats.average, stats.p99);
+        }
+        TimingStats gpuFrame = ComputeTimingStats(timers.gpuFrames);
+        TimingStats cpuFrame = ComputeTimingStats(timers.cpuFrames);
+        ImGui::Text("%-16s %8.3f %8.3f %8.3f", "GPU frame", gpuFrame.min, gpuFrame.average, gpuFrame.p99);
+        ImGui::Text("%-16s %8.3f %8.3f %8.3f", "Frame", cpuFrame.min, cpuFrame.average, cpuFrame.p99);
+        ImGui::Text("Dropped GPU timer frames: %u", timers.droppedFrames);
+
+        f32 samples[GPU_TIMER_HISTORY_SIZE];
+        u32 sampleCount = GetTimingSamples(timers.cpuFrames, samples);
+        ImGui::PlotLines("Frame", samples, sampleCount, 0, NULL, 0.0f, cpuFrame.p99 * 1.5f, ImVec2(0.0f, 60.0f));
+        sampleCount = GetTimingSamples(timers.gpuFrames, samples);
+        ImGui::PlotLines("GPU frame", samples, sampleCount, 0, NULL, 0.0f, gpuFrame.p99 * 1.5f, ImVec2(0.0f, 60.0f));
         ImGui::End();
     }
 }
 
 void Update(App* app)
 {
-    float currentFrame = (float)glfwGetTime();
-    app->deltaTime = currentFrame - app->lastFrame;
-    app->lastFrame = currentFrame;
+    PROFILE_SCOPE("Update");
+
+    AddTimingSample(app->gpuTimers.cpuFrames, app->deltaTime * 1000.0f);
+    UpdateTextureStreaming(app);
 
     //--Sprint--
     if (app->input.keys[K_SHIFT] == BUTTON_PRESSED)
@@ -704,49 +789,50 @@ void Update(App* app)
         app->camera.ProcessInput(CameraInput::Right);
     app->camera.UpdateCamera();
 
-    glBindBuffer(GL_UNIFORM_BUFFER, app->cbuffer.handle);
-    app->cbuffer.data = (u8*)glMapBuffer(GL_UNIFORM_BUFFER, GL_WRITE_ONLY);
-    app->cbuffer.head = 0;
+    //--Culling: invisible entities get neither uniforms nor draws--
+    CullEntities(app);
+
+    BeginUniformWrites(app->uniforms);
 
     //--Global Params--
-    app->globalParamsOffset = app->cbuffer.head;
-    PushVec3(app->cbuffer, app->camera.cameraPos);
-    PushUInt(app->cbuffer, app->lights.size());
+    //Bound as a single range: camera position and light count, then six vec4 slots per light at most
+    u32 globalParamsMaxSize = sizeof(vec4) * (1 + 6 * (u32)app->lights.size());
+    Buffer& globals = ReserveUniforms(app->uniforms, globalParamsMaxSize);
+    app->globalParamsBuffer = globals.handle;
+    app->globalParamsOffset = globals.head;
+    PushVec3(globals, app->camera.cameraPos);
+    PushUInt(globals, app->lights.size());
     for (u32 i = 0; i < app->lights.size(); ++i)
     {
-        AlignHead(app->cbuffer, sizeof(vec4));
+        AlignHead(globals, sizeof(vec4));
         Light& light = app->lights[i];
-        PushUInt(app->cbuffer, light.type);
-        PushVec3(app->cbuffer, light.position);
-        PushVec3(app->cbuffer, light.direction);
-        PushVec3(app->cbuffer, light.ambient);
-        PushVec3(app->cbuffer, light.diffuse);
-        PushVec3(app->cbuffer, light.specular);
-        PushFloat(app->cbuffer, light.constant);
+        PushUInt(globals, light.type);
+        PushVec3(globals, light.position);
+        PushVec3(globals, light.direction);
+        PushVec3(globals, light.ambient);
+        PushVec3(globals, light.diffuse);
+        PushVec3(globals, light.specular);
+        PushFloat(globals, light.constant);
     }
-    app->globalParamsSize = app->cbuffer.head - app->globalParamsOffset;
-
-    //--Local Params--
-    for (int i = 0; i < app->entities.size(); ++i)
-    {
-        AlignHead(app->cbuffer, app->uniformBufferAlignment);
+    app->globalParamsSize = globals.head - app->globalParamsOffset;
 
-        Entity* entity = app->entities[i];
-        glm::mat4 world = entity->worldMatrix;
-        glm::mat4 MVP = app->camera.projection * app->camera.view * world;
+    EndUniformWrites(app->uniforms);
 
-        entity->localParamsOffset = app->cbuffer.head;
-        PushMat4(app->cbuffer, world);
-        PushMat4(app->cbuffer, MVP);
-        entity->localParamsSize = app->cbuffer.head - entity->localParamsOffset;
-    }
+    //--Materials added since the last frame--
+    UploadMaterials(app);
 
-    glUnmapBuffer(GL_UNIFORM_BUFFER);
-    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    //--Instances: the matrices of the visible entities, grouped by model and submesh--
+    BeginUniformWrites(app->instanceBuffers);
+    BeginUniformWrites(app->indirectBuffers);
+    PackInstances(app);
+    EndUniformWrites(app->indirectBuffers);
+    EndUniformWrites(app->instanceBuffers);
 }
 
 void Render(App* app)
 {
+    PROFILE_SCOPE("Render");
+
     //--------------Render Loop Logic--------------
     //-Bind framebuffer
     //-Clear & enable tests
@@ -757,94 +843,100 @@ void Render(App* app)
     //-Clear
     //-Post processing pass
 
+    //ImGui and the uploads in Update changed GL state behind the cache's back
+    BeginGLStateFrame(app->glState);
+    BeginGpuTimerFrame(app->gpuTimers);
+
+    BeginGpuTimer(app->gpuTimers, GpuTimerPass_Geometry);
     GeometryPass(app);
+    EndGpuTimer(app->gpuTimers, GpuTimerPass_Geometry);
+    BeginGpuTimer(app->gpuTimers, GpuTimerPass_Lighting);
     LightingPass(app);
+    EndGpuTimer(app->gpuTimers, GpuTimerPass_Lighting);
+    BeginGpuTimer(app->gpuTimers, GpuTimerPass_PostProcessing);
     PostProcessingPass(app);
+    EndGpuTimer(app->gpuTimers, GpuTimerPass_PostProcessing);
+    EndGpuTimerFrame(app->gpuTimers);
+
+    //Every pass reading this frame's uniforms has been issued
+    FenceUniformWrites(app->uniforms);
+    FenceUniformWrites(app->instanceBuffers);
+    FenceUniformWrites(app->indirectBuffers);
 }
 
 void GeometryPass(App* app)
 {
-    glBindFramebuffer(GL_FRAMEBUFFER, app->framebufferHandle);
+    PROFILE_SCOPE("GeometryPass");
 
-    glEnable(GL_DEPTH_TEST);
-    glEnable(GL_CULL_FACE);
+    BindFramebuffer(app->glState, app->framebufferHandle);
+
+    SetCapability(app->glState, GLStateCapability_DepthTest, true);
+    SetCapability(app->glState, GLStateCapability_CullFace, true);
     glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
     glViewport(0, 0, app->displaySize.x, app->displaySize.y);
 
     //Global parameters binding buffer
-    glBindBufferRange(GL_UNIFORM_BUFFER, BINDING(0), app->cbuffer.handle, app->globalParamsOffset, app->globalParamsSize);
+    glBindBufferRange(GL_UNIFORM_BUFFER, BINDING(0), app->globalParamsBuffer, app->globalParamsOffset, app->globalParamsSize);
 
-    //Per entity
-    for (int i = 0; i < app->entities.size(); ++i)
+    Program& texturedMeshProgram = app->programs[app->texturedMeshProgramIdx];
+    UseProgram(app->glState, texturedMeshProgram.handle);
+
+    //Material parameters, indexed through the instance data
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, MATERIAL_BUFFER_BINDING, app->registry.materialBuffer);
+
+    //Diffuse texture unit, the texture itself changes per multi-draw
+    glUniform1i(app->programUniformDiffuse, 0);
+
+    //Per arena, albedo texture and instance block, see PackInstances
+    for (const MultiDraw& multiDraw : app->instancing.multiDraws)
     {
-        //Local parameters binding buffer
-        glBindBufferRange(GL_UNIFORM_BUFFER, BINDING(1), app->cbuffer.handle, app->entities[i]->localParamsOffset, app->entities[i]->localParamsSize);
+        BindVertexArray(app->glState, FindMeshArenaVAO(app, multiDraw.arenaIdx, texturedMeshProgram));
 
-        Program& texturedMeshProgram = app->programs[app->texturedMeshProgramIdx];
-        glUseProgram(texturedMeshProgram.handle);
-        Model& model = app->models[app->entities[i]->modelIdx];
-        Mesh& mesh = app->meshes[model.meshIdx];
+        //Instance parameters binding buffer, indexed from its start by the base instances
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, BINDING(1), multiDraw.instanceBuffer);
 
-        //Per submesh
-        for (u32 i = 0; i < mesh.submeshes.size(); ++i)
-        {
-            GLuint VAO = FindVAO(mesh, i, texturedMeshProgram);
-            glBindVertexArray(VAO);
-
-            u32 submeshMaterialIdx = model.materialIdx[i];
-            Material& submeshMaterial = app->materials[submeshMaterialIdx];
-
-            glActiveTexture(GL_TEXTURE0);
-            //diffuse
-            glBindTexture(GL_TEXTURE_2D, app->textures[submeshMaterial.albedoTextureIdx].handle);
-            glUniform1i(app->programUniformDiffuse, 0);
-            //specular
-            glUniform3fv(glGetUniformLocation(texturedMeshProgram.handle, "material.specular"), 1, glm::value_ptr(submeshMaterial.specular));
-            //shininess
-            glUniform1f(glGetUniformLocation(texturedMeshProgram.handle, "material.shininess"), submeshMaterial.smoothness);
-
-            Submesh& submesh = mesh.submeshes[i];
-            glDrawElements(GL_TRIANGLES, submesh.indices.size(), GL_UNSIGNED_INT, (void*)(u64)submesh.indexOffset);
-        }
+        BindTexture2D(app->glState, 0, app->textures[multiDraw.albedoTextureIdx].handle);
+
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, multiDraw.commandBuffer);
+        glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (void*)(u64)multiDraw.commandOffset, multiDraw.commandCount, 0);
     }
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    BindVertexArray(app->glState, 0);
 }
 
 void LightingPass(App* app)
 {
-    glBindFramebuffer(GL_FRAMEBUFFER, app->framebufferPostProcessingHandle);
-    glDisable(GL_DEPTH_TEST);
+    PROFILE_SCOPE("LightingPass");
+
+    BindFramebuffer(app->glState, app->framebufferPostProcessingHandle);
+    SetCapability(app->glState, GLStateCapability_DepthTest, false);
     glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-    glUseProgram(app->programs[app->texturedQuadProgramIdx].handle);
-    glBindVertexArray(app->vaoIdx);
+    UseProgram(app->glState, app->programs[app->texturedQuadProgramIdx].handle);
+    BindVertexArray(app->glState, app->vaoIdx);
 
     //Render target
     glUniform1i(app->programUniformRenderTarget, app->currentRenderTarget);
 
     //Position attachment
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, app->positionAttachmentHandle);
+    BindTexture2D(app->glState, 0, app->positionAttachmentHandle);
     glUniform1i(app->programUniformLightingPosition, 0);
 
     //Normal attachment
-    glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, app->normalAttachmentHandle);
+    BindTexture2D(app->glState, 1, app->normalAttachmentHandle);
     glUniform1i(app->programUniformLightingNormal, 1);
 
     //Albedo attachment
-    glActiveTexture(GL_TEXTURE2);
-    glBindTexture(GL_TEXTURE_2D, app->albedoAttachmentHandle);
+    BindTexture2D(app->glState, 2, app->albedoAttachmentHandle);
     glUniform1i(app->programUniformLightingAlbedo, 2);
 
     //Specular attachment
-    glActiveTexture(GL_TEXTURE3);
-    glBindTexture(GL_TEXTURE_2D, app->specularAttachmentHandle);
+    BindTexture2D(app->glState, 3, app->specularAttachmentHandle);
     glUniform1i(app->programUniformLightingSpec, 3);
 
     //Depth attachment
-    glActiveTexture(GL_TEXTURE4);
-    glBindTexture(GL_TEXTURE_2D, app->depthAttachmentHandle);
+    BindTexture2D(app->glState, 4, app->depthAttachmentHandle);
     glUniform1i(app->programUniformLightingDepth, 4);
 
     glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, (void*)0);
@@ -852,15 +944,16 @@ void LightingPass(App* app)
 
 void PostProcessingPass(App* app)
 {
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    PROFILE_SCOPE("PostProcessingPass");
+
+    BindFramebuffer(app->glState, 0);
     glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-    glUseProgram(app->programs[app->texturedQuadProgramIdx].handle);
-    glBindVertexArray(app->vaoIdx);
+    UseProgram(app->glState, app->programs[app->texturedQuadProgramIdx].handle);
+    BindVertexArray(app->glState, app->vaoIdx);
 
     //Final color attachment
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, app->finalColorAttachmentHandle);
+    BindTexture2D(app->glState, 0, app->finalColorAttachmentHandle);
     glUniform1i(app->programUniformPostProcessing, 0);
 
     glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, (void*)0);
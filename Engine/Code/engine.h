@@ -8,6 +8,20 @@
 #include "Debugging.h"
 #include <glad/glad.h>
 #include "Camera.h"
+#include "job_system.h"
+#include "texture_streaming.h"
+#include "texture_baking.h"
+#include "resource_registry.h"
+#include "culling.h"
+#include "entity_store.h"
+#include "instancing.h"
+#include "mesh_arena.h"
+#include "gl_state.h"
+#include "program_cache.h"
+#include "profiler.h"
+#include "gpu_timers.h"
+#include "scene.h"
+#include "benchmark.h"
 
 typedef glm::vec2 vec2;
 typedef glm::vec3 vec3;
@@ -46,6 +60,7 @@ struct Program
     std::string programName;
     u64 lastWriteTimestamp = 0;
     VertexBufferLayout vertexInputLayout;
+    std::unordered_map<std::string, GLint> uniformLocations; //Reflected once by LoadProgram
 
     Program(GLuint _handle = 0,u64 _lastWriteTimestamp = 0)
         : handle(_handle),lastWriteTimestamp(_lastWriteTimestamp)
@@ -70,30 +85,23 @@ struct Model
 struct Submesh
 {
     VertexBufferLayout vertexBufferLayout;
-    std::vector<f32> vertices;
-    std::vector<u32> indices;
-    u32 vertexOffset = 0;
-    u32 indexOffset = 0;
-    std::vector<VAO> vaos;
-
-    Submesh(u32 _vertexOffset = 0, u32 _indexOffset = 0)
-        : vertexOffset(_vertexOffset), indexOffset(_indexOffset)
+    u32 arenaIdx = 0;   //Into App::meshArenas, the one holding this vertex format
+    u32 baseVertex = 0; //Inside the arena
+    u32 firstIndex = 0; //Inside the arena
+    u32 indexCount = 0;
+    AABB bounds; //Model space
+
+    Submesh()
     {
         vertexBufferLayout = VertexBufferLayout();
-        vertices.clear();
-        indices.clear();
-        vaos.clear();
     }
 };
 
 struct Mesh
 {
     std::vector<Submesh> submeshes;
-    GLuint vertexBufferHandle = 0;
-    GLuint indexBufferHandle = 0;
 
-    Mesh(GLuint _vertexBufferHandle = 0,GLuint _indexBufferHandle = 0)
-        : vertexBufferHandle(_vertexBufferHandle),indexBufferHandle(_indexBufferHandle)
+    Mesh()
     {
         submeshes.clear();
     }
@@ -139,18 +147,6 @@ struct Material
     {}
 };
 
-struct Entity
-{
-    glm::mat4 worldMatrix;
-    u32 modelIdx = 0;
-    u32 localParamsOffset = 0;
-    u32 localParamsSize = 0;
-
-    Entity(glm::mat4 worldMat, u32 modelIndex, u32 localOffset = 0, u32 localSize = 0)
-        : worldMatrix(worldMat),modelIdx(modelIndex),localParamsOffset(localOffset),localParamsSize(localSize)
-    {}
-};
-
 enum LightType
 {
     Directional_Light = 0,
@@ -173,6 +169,17 @@ struct Light
     {}
 };
 
+//Size of the uLight arrays of shaders.glsl: 96 bytes per light keeps GlobalParams under the
+//16 KB GL_MAX_UNIFORM_BLOCK_SIZE every implementation supports
+#define MAX_LIGHTS 128
+
+#define BUFFER_RING_REGIONS 3
+#define UNIFORM_BLOCK_REGION_SIZE MB(1)
+#define INSTANCE_BLOCK_REGION_SIZE MB(4)
+#define INDIRECT_BLOCK_REGION_SIZE KB(256)
+
+#define CPU_TRACE_FILEPATH "cpu_trace.json" //Relative to the working directory
+
 struct Buffer
 {
     GLuint handle;
@@ -180,13 +187,32 @@ struct Buffer
     GLint size = 0;
     GLint head = 0;
     void* data; //Mapped data
+
+    //Ring buffers only: one region per frame in flight, each guarded by a fence
+    GLint regionSize = 0;
+    u32 regionIdx = 0;
+    GLsync regionFences[BUFFER_RING_REGIONS] = {};
+    bool isPersistent = false;
+};
+
+//Per frame shader data spread over as many ring buffers as it needs. A uniform block is
+//bound by ranges no larger than GL_MAX_UNIFORM_BLOCK_SIZE, but the buffer behind them is
+//not limited by it, so when a region fills up the allocator moves on to the next block,
+//creating it the first frame it is needed. Instance data uses the same scheme with shader
+//storage blocks.
+struct UniformAllocator
+{
+    std::vector<Buffer> blocks;
+    u32 usedBlockCount = 0; //Blocks mapped this frame
+    u32 regionSize = 0;
+    u32 alignment = 0;
+    GLenum type = GL_UNIFORM_BUFFER;
 };
 
 struct App
 {
     //--Loop--
     float deltaTime = 0.0f;
-    float lastFrame = 0.0f;
     bool isRunning;
 
     //--Graphics--
@@ -207,7 +233,8 @@ struct App
     std::vector<Model> models;
     std::vector<Program>  programs;
     std::vector<Light> lights;
-    std::vector<Entity*> entities;
+    EntityStore entities;
+    const SceneDescription* scene = NULL; //Replaces the built-in scene of Init when set
 
     //--VAO index--
     GLuint vaoIdx;
@@ -222,14 +249,43 @@ struct App
     u32 postProcessingProgramIdx;
 
     //--Global Params--
+    GLuint globalParamsBuffer;
     u32 globalParamsOffset;
     u32 globalParamsSize;
 
-    //--Uniform buffer--
-    Buffer cbuffer;
+    //--Uniform buffers--
+    UniformAllocator uniforms;
     int maxUniformBufferSize;
     int uniformBufferAlignment;
 
+    //--Static geometry, one arena per vertex format--
+    std::vector<MeshArena> meshArenas;
+
+    //--Instancing and indirect draws--
+    UniformAllocator instanceBuffers;
+    UniformAllocator indirectBuffers;
+    InstanceBatches instancing;
+    int storageBufferAlignment;
+
+    //--Jobs for the frame and asset loading work--
+    JobSystem jobs;
+
+    //--Bound GL state, see gl_state.h--
+    GLStateCache glState;
+
+    //--Per pass GPU time and frame time history--
+    GpuTimers gpuTimers;
+
+    //--Frustum culling--
+    CullingBounds cullingBounds;
+    CullingStats cullingStats;
+
+    //--Lookups over textures and materials--
+    ResourceRegistry registry;
+
+    //--Texture streaming--
+    TextureStreamer textureStreamer;
+
     //--Texture indices--
     u32 diceTexIdx;
     u32 whiteTexIdx;
@@ -278,16 +334,30 @@ struct App
 
 GLuint CreateProgramFromSource(String programSource, const char* shaderName);
 u32 LoadProgram(App* app, const char* filepath, const char* programName);
+
+/**
+ * Location of a uniform of the program from the table built when it was loaded, -1 if the
+ * program has no such active uniform. Array uniforms are found with and without "[0]".
+ */
+GLint GetUniformLocation(const Program& program, const char* name);
 Image LoadImage(const char* filename);
 void FreeImage(Image image);
 GLuint CreateTexture2DFromImage(Image image);
 u32 LoadTexture2D(App* app, const char* filepath);
 
+/**
+ * Loads a batch of textures: the images are decoded concurrently on a worker pool and
+ * then uploaded on the calling (GL) thread. Paths with an up to date baked version
+ * (see texture_baking.h) skip the decoding. Already loaded and repeated paths are only
+ * decoded once. textureIndices receives one index per path, UINT32_MAX on failure.
+ */
+void LoadTextures2D(App* app, const char* const* filepaths, u32 count, u32* textureIndices);
+
 u32 CreateTextureQuad(App* app);
 void CreateTextureQuadGeometry(App* app, Material myMaterial);
-GLuint FindVAO(Mesh& mesh, u32 submeshIndex, const Program& program);
 
 void Init(App* app);
+void Shutdown(App* app);
 void InfoInit(App* app);
 void DebugInit();
 void FrameBufferInit(App* app);
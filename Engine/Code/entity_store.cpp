@@ -0,0 +1,77 @@
+#include "entity_store.h"
+
+EntityHandle AddEntity(EntityStore& store, const glm::mat4& worldMatrix, u32 modelIdx)
+{
+    u32 slot;
+    if (!store.freeSlots.empty())
+    {
+        slot = store.freeSlots.back();
+        store.freeSlots.pop_back();
+    }
+    else
+    {
+        slot = (u32)store.slotToDense.size();
+        store.slotToDense.push_back(INVALID_ENTITY_INDEX);
+        store.slotGenerations.push_back(0);
+    }
+
+    u32 entityIdx = store.count++;
+    store.worldMatrices.push_back(worldMatrix);
+    store.modelIndices.push_back(modelIdx);
+    store.firstBoundsIndices.push_back(0);
+    store.isVisible.push_back(1);
+    store.denseToSlot.push_back(slot);
+    store.slotToDense[slot] = entityIdx;
+
+    EntityHandle handle;
+    handle.slot = slot;
+    handle.generation = store.slotGenerations[slot];
+    return handle;
+}
+
+bool RemoveEntity(EntityStore& store, EntityHandle handle)
+{
+    u32 entityIdx = GetEntityIndex(store, handle);
+    if (entityIdx == INVALID_ENTITY_INDEX)
+        return false;
+
+    //Move the last entity into the hole
+    u32 lastIdx = store.count - 1;
+    if (entityIdx != lastIdx)
+    {
+        store.worldMatrices[entityIdx] = store.worldMatrices[lastIdx];
+        store.modelIndices[entityIdx] = store.modelIndices[lastIdx];
+        store.firstBoundsIndices[entityIdx] = store.firstBoundsIndices[lastIdx];
+        store.isVisible[entityIdx] = store.isVisible[lastIdx];
+        store.denseToSlot[entityIdx] = store.denseToSlot[lastIdx];
+        store.slotToDense[store.denseToSlot[entityIdx]] = entityIdx;
+    }
+    store.worldMatrices.pop_back();
+    store.modelIndices.pop_back();
+    store.firstBoundsIndices.pop_back();
+    store.isVisible.pop_back();
+    store.denseToSlot.pop_back();
+    --store.count;
+
+    //A new generation invalidates every handle to the removed entity
+    store.slotToDense[handle.slot] = INVALID_ENTITY_INDEX;
+    ++store.slotGenerations[handle.slot];
+    store.freeSlots.push_back(handle.slot);
+    return true;
+}
+
+u32 GetEntityIndex(const EntityStore& store, EntityHandle handle)
+{
+    if (handle.slot >= store.slotToDense.size() || store.slotGenerations[handle.slot] != handle.generation)
+        return INVALID_ENTITY_INDEX;
+    return store.slotToDense[handle.slot];
+}
+
+EntityHandle GetEntityHandle(const EntityStore& store, u32 entityIdx)
+{
+    ASSERT(entityIdx < store.count, "Entity index out of range");
+    EntityHandle handle;
+    handle.slot = store.denseToSlot[entityIdx];
+    handle.generation = store.slotGenerations[handle.slot];
+    return handle;
+}
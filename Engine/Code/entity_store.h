@@ -0,0 +1,60 @@
+#pragma once
+
+#include "platform.h"
+
+//Entities live in parallel arrays, one per component, packed in [0, count) so the per frame
+//loops (culling, instance packing) walk contiguous memory. Removing an entity moves the
+//last one into its place, so dense indices are only stable until the next removal; code
+//that keeps an entity around holds an EntityHandle instead. Handles index a slot table
+//mapping them to the current dense index, and carry the generation of the slot they were
+//created with, so a handle to a removed entity is detected even once its slot is reused.
+
+#define INVALID_ENTITY_INDEX UINT32_MAX
+
+struct EntityHandle
+{
+    u32 slot = UINT32_MAX;
+    u32 generation = 0;
+};
+
+struct EntityStore
+{
+    //--Components, indexed by dense index--
+    std::vector<glm::mat4> worldMatrices;
+    std::vector<u32> modelIndices;
+    std::vector<u32> firstBoundsIndices; //Into App::cullingBounds, one entry per submesh
+    std::vector<u8> isVisible;
+    std::vector<u32> denseToSlot;
+    u32 count = 0;
+
+    //--Handle slots--
+    std::vector<u32> slotToDense;
+    std::vector<u32> slotGenerations;
+    std::vector<u32> freeSlots;
+};
+
+/**
+ * Appends an entity, reusing a free slot for its handle if there is one. O(1) amortized.
+ */
+EntityHandle AddEntity(EntityStore& store, const glm::mat4& worldMatrix, u32 modelIdx);
+
+/**
+ * Removes the entity if the handle is still alive, moving the last entity into its place.
+ * O(1). Returns false for stale handles.
+ */
+bool RemoveEntity(EntityStore& store, EntityHandle handle);
+
+/**
+ * Dense index of the entity, INVALID_ENTITY_INDEX if the handle is stale.
+ */
+u32 GetEntityIndex(const EntityStore& store, EntityHandle handle);
+
+inline bool IsEntityAlive(const EntityStore& store, EntityHandle handle)
+{
+    return GetEntityIndex(store, handle) != INVALID_ENTITY_INDEX;
+}
+
+/**
+ * Handle of the entity currently at the given dense index.
+ */
+EntityHandle GetEntityHandle(const EntityStore& store, u32 entityIdx);
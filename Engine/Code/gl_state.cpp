@@ -0,0 +1,81 @@
+#include "gl_state.h"
+#include <string.h>
+
+static const GLenum CapabilityEnums[GLStateCapability_Count] = { GL_DEPTH_TEST, GL_CULL_FACE, GL_BLEND };
+
+GLStateCache::GLStateCache()
+{
+    memset(textures2D, 0xFF, sizeof(textures2D));
+    memset(capabilities, 0xFF, sizeof(capabilities));
+}
+
+void BeginGLStateFrame(GLStateCache& cache)
+{
+    u32 issuedCalls = cache.issuedCalls;
+    u32 elidedCalls = cache.elidedCalls;
+    cache = GLStateCache();
+    cache.lastFrameIssuedCalls = issuedCalls;
+    cache.lastFrameElidedCalls = elidedCalls;
+}
+
+//Returns whether the call has to be issued, updating the cached value and the counters
+static bool ChangeState(GLStateCache& cache, GLuint& cached, GLuint value)
+{
+    if (cached == value)
+    {
+        ++cache.elidedCalls;
+        return false;
+    }
+    cached = value;
+    ++cache.issuedCalls;
+    return true;
+}
+
+void UseProgram(GLStateCache& cache, GLuint program)
+{
+    if (ChangeState(cache, cache.program, program))
+        glUseProgram(program);
+}
+
+void BindVertexArray(GLStateCache& cache, GLuint vertexArray)
+{
+    if (ChangeState(cache, cache.vertexArray, vertexArray))
+        glBindVertexArray(vertexArray);
+}
+
+void BindFramebuffer(GLStateCache& cache, GLuint framebuffer)
+{
+    if (ChangeState(cache, cache.framebuffer, framebuffer))
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+}
+
+void BindTexture2D(GLStateCache& cache, u32 unit, GLuint texture)
+{
+    ASSERT(unit < GL_STATE_TEXTURE_UNITS, "Texture unit out of the cached range");
+    if (cache.textures2D[unit] == texture)
+    {
+        ++cache.elidedCalls;
+        return;
+    }
+
+    if (ChangeState(cache, cache.activeTextureUnit, unit))
+        glActiveTexture(GL_TEXTURE0 + unit);
+    ChangeState(cache, cache.textures2D[unit], texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+}
+
+void SetCapability(GLStateCache& cache, GLStateCapability capability, bool enabled)
+{
+    if (cache.capabilities[capability] == (u8)enabled)
+    {
+        ++cache.elidedCalls;
+        return;
+    }
+
+    cache.capabilities[capability] = (u8)enabled;
+    ++cache.issuedCalls;
+    if (enabled)
+        glEnable(CapabilityEnums[capability]);
+    else
+        glDisable(CapabilityEnums[capability]);
+}
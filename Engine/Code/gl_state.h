@@ -0,0 +1,57 @@
+#pragma once
+
+#include "platform.h"
+#include <glad/glad.h>
+
+//Thin filter in front of the GL binding calls of the render passes: it remembers what is
+//bound and skips the calls that would not change anything. Anything else touching the same
+//state (ImGui, resource uploads) runs outside of Render, so the cache is simply forgotten
+//at the start of every frame rather than kept in sync with it.
+
+#define GL_STATE_TEXTURE_UNITS 16
+#define GL_STATE_UNKNOWN 0xFFFFFFFFu
+
+enum GLStateCapability
+{
+    GLStateCapability_DepthTest = 0,
+    GLStateCapability_CullFace,
+    GLStateCapability_Blend,
+    GLStateCapability_Count
+};
+
+struct GLStateCache
+{
+    GLuint program = GL_STATE_UNKNOWN;
+    GLuint vertexArray = GL_STATE_UNKNOWN;
+    GLuint framebuffer = GL_STATE_UNKNOWN;
+    GLuint activeTextureUnit = GL_STATE_UNKNOWN;
+    GLuint textures2D[GL_STATE_TEXTURE_UNITS];
+    u8 capabilities[GLStateCapability_Count]; //0, 1 or 0xFF while unknown
+
+    //Calls issued and skipped, this frame and the previous one
+    u32 issuedCalls = 0;
+    u32 elidedCalls = 0;
+    u32 lastFrameIssuedCalls = 0;
+    u32 lastFrameElidedCalls = 0;
+
+    GLStateCache();
+};
+
+/**
+ * Forgets the cached state and starts counting the calls of a new frame.
+ */
+void BeginGLStateFrame(GLStateCache& cache);
+
+void UseProgram(GLStateCache& cache, GLuint program);
+void BindVertexArray(GLStateCache& cache, GLuint vertexArray);
+void BindFramebuffer(GLStateCache& cache, GLuint framebuffer);
+
+/**
+ * Binds a 2D texture to the given unit, switching the active unit only if needed.
+ */
+void BindTexture2D(GLStateCache& cache, u32 unit, GLuint texture);
+
+/**
+ * glEnable/glDisable of GL_DEPTH_TEST, GL_CULL_FACE or GL_BLEND.
+ */
+void SetCapability(GLStateCache& cache, GLStateCapability capability, bool enabled);
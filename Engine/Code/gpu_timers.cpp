@@ -0,0 +1,138 @@
+#include "gpu_timers.h"
+#include <algorithm>
+
+const char* GetGpuTimerPassName(GpuTimerPass pass)
+{
+    switch (pass)
+    {
+    case GpuTimerPass_Geometry: return "Geometry";
+    case GpuTimerPass_Lighting: return "Lighting";
+    case GpuTimerPass_PostProcessing: return "Post processing";
+    default: return "Unknown";
+    }
+}
+
+void CreateGpuTimers(GpuTimers& timers)
+{
+    for (GpuTimerFrame& frame : timers.frames)
+    {
+        glGenQueries(GpuTimerPass_Count * 2, &frame.queries[0][0]);
+        for (u32 pass = 0; pass < GpuTimerPass_Count; ++pass)
+            frame.isPassTimed[pass] = false;
+        frame.isPending = false;
+    }
+    timers.frameIdx = 0;
+}
+
+void DestroyGpuTimers(GpuTimers& timers)
+{
+    for (GpuTimerFrame& frame : timers.frames)
+        glDeleteQueries(GpuTimerPass_Count * 2, &frame.queries[0][0]);
+}
+
+static void ReadGpuTimerFrame(GpuTimers& timers, const GpuTimerFrame& frame)
+{
+    //The last query issued is the last to complete
+    GLuint lastQuery = 0;
+    for (u32 pass = 0; pass < GpuTimerPass_Count; ++pass)
+        if (frame.isPassTimed[pass])
+            lastQuery = frame.queries[pass][1];
+    if (!lastQuery)
+        return;
+
+    GLint isAvailable = 0;
+    glGetQueryObjectiv(lastQuery, GL_QUERY_RESULT_AVAILABLE, &isAvailable);
+    if (!isAvailable)
+    {
+        ++timers.droppedFrames;
+        return;
+    }
+
+    GLuint64 frameBegin = UINT64_MAX, frameEnd = 0;
+    for (u32 pass = 0; pass < GpuTimerPass_Count; ++pass)
+    {
+        if (!frame.isPassTimed[pass])
+            continue;
+
+        GLuint64 begin = 0, end = 0;
+        glGetQueryObjectui64v(frame.queries[pass][0], GL_QUERY_RESULT, &begin);
+        glGetQueryObjectui64v(frame.queries[pass][1], GL_QUERY_RESULT, &end);
+        AddTimingSample(timers.passes[pass], (end - begin) / 1000000.0f);
+        frameBegin = glm::min(frameBegin, begin);
+        frameEnd = glm::max(frameEnd, end);
+    }
+    AddTimingSample(timers.gpuFrames, (frameEnd - frameBegin) / 1000000.0f);
+    ++timers.resolvedFrames;
+}
+
+void BeginGpuTimerFrame(GpuTimers& timers)
+{
+    GpuTimerFrame& frame = timers.frames[timers.frameIdx];
+    if (frame.isPending)
+        ReadGpuTimerFrame(timers, frame);
+
+    frame.isPending = false;
+    for (u32 pass = 0; pass < GpuTimerPass_Count; ++pass)
+        frame.isPassTimed[pass] = false;
+}
+
+void EndGpuTimerFrame(GpuTimers& timers)
+{
+    timers.frameIdx = (timers.frameIdx + 1) % GPU_TIMER_FRAME_LATENCY;
+}
+
+void BeginGpuTimer(GpuTimers& timers, GpuTimerPass pass)
+{
+    GpuTimerFrame& frame = timers.frames[timers.frameIdx];
+    glQueryCounter(frame.queries[pass][0], GL_TIMESTAMP);
+}
+
+void EndGpuTimer(GpuTimers& timers, GpuTimerPass pass)
+{
+    GpuTimerFrame& frame = timers.frames[timers.frameIdx];
+    glQueryCounter(frame.queries[pass][1], GL_TIMESTAMP);
+    frame.isPassTimed[pass] = true;
+    frame.isPending = true;
+}
+
+void AddTimingSample(TimingHistory& history, f32 milliseconds)
+{
+    history.samples[history.next] = milliseconds;
+    history.next = (history.next + 1) % GPU_TIMER_HISTORY_SIZE;
+    history.count = glm::min(history.count + 1, (u32)GPU_TIMER_HISTORY_SIZE);
+}
+
+TimingStats ComputeTimingStats(const TimingHistory& history)
+{
+    TimingStats stats;
+    if (history.count == 0)
+        return stats;
+
+    f32 sorted[GPU_TIMER_HISTORY_SIZE];
+    u32 count = GetTimingSamples(history, sorted);
+    std::sort(sorted, sorted + count);
+
+    f32 sum = 0.0f;
+    for (u32 i = 0; i < count; ++i)
+        sum += sorted[i];
+
+    stats.min = sorted[0];
+    stats.average = sum / count;
+    stats.p99 = sorted[glm::min((u32)(count * 0.99f), count - 1)];
+    return stats;
+}
+
+f32 GetLatestTimingSample(const TimingHistory& history)
+{
+    if (history.count == 0)
+        return 0.0f;
+    return history.samples[(history.next + GPU_TIMER_HISTORY_SIZE - 1) % GPU_TIMER_HISTORY_SIZE];
+}
+
+u32 GetTimingSamples(const TimingHistory& history, f32* samples)
+{
+    u32 first = (history.next + GPU_TIMER_HISTORY_SIZE - history.count) % GPU_TIMER_HISTORY_SIZE;
+    for (u32 i = 0; i < history.count; ++i)
+        samples[i] = history.samples[(first + i) % GPU_TIMER_HISTORY_SIZE];
+    return history.count;
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "platform.h"
+#include <glad/glad.h>
+
+//GPU time of each render pass, from GL_TIMESTAMP queries issued around it. The queries of a
+//frame are only read GPU_TIMER_FRAME_LATENCY frames later, once the GPU is done with them,
+//and only if their results are available by then, so reading never stalls; a frame whose
+//results are late is dropped rather than waited for. The last GPU_TIMER_HISTORY_SIZE
+//samples of every pass, of the whole GPU frame and of the CPU frame time are kept for the
+//statistics and graphs of the Engine window.
+
+#define GPU_TIMER_FRAME_LATENCY 3 //As many frames as the uniform rings keep in flight
+#define GPU_TIMER_HISTORY_SIZE 240
+
+enum GpuTimerPass
+{
+    GpuTimerPass_Geometry = 0,
+    GpuTimerPass_Lighting,
+    GpuTimerPass_PostProcessing,
+    GpuTimerPass_Count
+};
+
+//Fixed size ring of samples in milliseconds
+struct TimingHistory
+{
+    f32 samples[GPU_TIMER_HISTORY_SIZE] = {};
+    u32 next = 0;
+    u32 count = 0;
+};
+
+struct TimingStats
+{
+    f32 min = 0.0f;
+    f32 average = 0.0f;
+    f32 p99 = 0.0f;
+};
+
+struct GpuTimerFrame
+{
+    GLuint queries[GpuTimerPass_Count][2]; //Begin and end timestamps
+    bool isPassTimed[GpuTimerPass_Count];
+    bool isPending;
+};
+
+struct GpuTimers
+{
+    GpuTimerFrame frames[GPU_TIMER_FRAME_LATENCY];
+    u32 frameIdx = 0;
+    u32 droppedFrames = 0;
+    u32 resolvedFrames = 0; //Frames whose samples were added to the histories
+
+    TimingHistory passes[GpuTimerPass_Count];
+    TimingHistory gpuFrames; //From the first pass begin to the last pass end
+    TimingHistory cpuFrames;
+};
+
+const char* GetGpuTimerPassName(GpuTimerPass pass);
+
+void CreateGpuTimers(GpuTimers& timers);
+void DestroyGpuTimers(GpuTimers& timers);
+
+/**
+ * Reads the results of the frame whose queries are about to be reused, if they are
+ * available. Call it once per frame before the first BeginGpuTimer.
+ */
+void BeginGpuTimerFrame(GpuTimers& timers);
+
+/**
+ * Moves on to the next frame's queries. Call it once all passes have been issued.
+ */
+void EndGpuTimerFrame(GpuTimers& timers);
+
+void BeginGpuTimer(GpuTimers& timers, GpuTimerPass pass);
+void EndGpuTimer(GpuTimers& timers, GpuTimerPass pass);
+
+void AddTimingSample(TimingHistory& history, f32 milliseconds);
+
+/**
+ * Min, average and 99th percentile over the samples in the history.
+ */
+TimingStats ComputeTimingStats(const TimingHistory& history);
+
+/**
+ * The most recent sample, 0 if there is none.
+ */
+f32 GetLatestTimingSample(const TimingHistory& history);
+
+/**
+ * The samples from oldest to newest, for plotting. Returns how many were written.
+ */
+u32 GetTimingSamples(const TimingHistory& history, f32* samples);
@@ -0,0 +1,76 @@
+#include "instance_packing.h"
+#include <float.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define INSTANCE_PACKING_USE_SSE 1
+#include <emmintrin.h>
+#endif
+
+f32 WriteInstances(InstanceData* instances, const glm::mat4* worldMatrices, const u32* entityIndices, u32 count,
+    const glm::mat4& viewProjection, u32 materialIdx)
+{
+    f32 viewDepth = FLT_MAX;
+
+#ifdef INSTANCE_PACKING_USE_SSE
+    const __m128 viewProjection0 = _mm_loadu_ps(&viewProjection[0][0]);
+    const __m128 viewProjection1 = _mm_loadu_ps(&viewProjection[1][0]);
+    const __m128 viewProjection2 = _mm_loadu_ps(&viewProjection[2][0]);
+    const __m128 viewProjection3 = _mm_loadu_ps(&viewProjection[3][0]);
+    __m128 minTranslation = _mm_set1_ps(FLT_MAX);
+
+    for (u32 i = 0; i < count; ++i)
+    {
+        const glm::mat4& world = worldMatrices[entityIndices[i]];
+        __m128 columns[4] = {
+            _mm_loadu_ps(&world[0][0]),
+            _mm_loadu_ps(&world[1][0]),
+            _mm_loadu_ps(&world[2][0]),
+            _mm_loadu_ps(&world[3][0])
+        };
+
+        //Every MVP column is the view projection columns weighted by a world column, summed
+        //in the same order as glm so both paths give the same bits
+        InstanceData& instance = instances[i];
+        for (u32 c = 0; c < 4; ++c)
+        {
+            __m128 column = columns[c];
+            __m128 result = _mm_mul_ps(viewProjection0, _mm_shuffle_ps(column, column, _MM_SHUFFLE(0, 0, 0, 0)));
+            result = _mm_add_ps(result, _mm_mul_ps(viewProjection1, _mm_shuffle_ps(column, column, _MM_SHUFFLE(1, 1, 1, 1))));
+            result = _mm_add_ps(result, _mm_mul_ps(viewProjection2, _mm_shuffle_ps(column, column, _MM_SHUFFLE(2, 2, 2, 2))));
+            result = _mm_add_ps(result, _mm_mul_ps(viewProjection3, _mm_shuffle_ps(column, column, _MM_SHUFFLE(3, 3, 3, 3))));
+            _mm_storeu_ps(&instance.MVP[c][0], result);
+            if (c == 3)
+                minTranslation = _mm_min_ps(minTranslation, result);
+        }
+
+        _MM_TRANSPOSE4_PS(columns[0], columns[1], columns[2], columns[3]);
+        _mm_storeu_ps(&instance.worldRows[0][0], columns[0]);
+        _mm_storeu_ps(&instance.worldRows[1][0], columns[1]);
+        _mm_storeu_ps(&instance.worldRows[2][0], columns[2]);
+        instance.materialIdx = materialIdx;
+    }
+
+    //The clip space w of the origin is its depth along the view direction. It is taken from
+    //the registers since the block is write combined memory, slow to read back.
+    viewDepth = _mm_cvtss_f32(_mm_shuffle_ps(minTranslation, minTranslation, _MM_SHUFFLE(3, 3, 3, 3)));
+#else
+    for (u32 i = 0; i < count; ++i)
+    {
+        const glm::mat4& world = worldMatrices[entityIndices[i]];
+        const glm::mat4 worldRows = glm::transpose(world);
+        const glm::mat4 MVP = viewProjection * world;
+
+        InstanceData& instance = instances[i];
+        instance.worldRows[0] = worldRows[0];
+        instance.worldRows[1] = worldRows[1];
+        instance.worldRows[2] = worldRows[2];
+        instance.MVP = MVP;
+        instance.materialIdx = materialIdx;
+
+        //The clip space w of the origin is its depth along the view direction
+        viewDepth = glm::min(viewDepth, MVP[3][3]);
+    }
+#endif
+
+    return viewDepth;
+}
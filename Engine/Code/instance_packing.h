@@ -0,0 +1,16 @@
+#pragma once
+
+#include "platform.h"
+#include "instancing.h"
+
+//The per instance math of PackInstances: world rows and MVP of a range of entities,
+//written straight to the mapped storage block. It is kept apart from instancing.cpp, which
+//owns the GL side, so CPU only benchmarks can link it on its own.
+
+/**
+ * Writes the instance data of worldMatrices[entityIndices[0..count)] to instances, sharing the
+ * given view projection and material. Returns the nearest view depth of their origins.
+ * Uses SSE when available.
+ */
+f32 WriteInstances(InstanceData* instances, const glm::mat4* worldMatrices, const u32* entityIndices, u32 count,
+    const glm::mat4& viewProjection, u32 materialIdx);
@@ -0,0 +1,238 @@
+#include "instancing.h"
+#include "engine.h"
+#include "instance_packing.h"
+#include <float.h>
+
+static_assert(sizeof(InstanceData) == 128, "InstanceData must match the std430 Instance struct");
+
+static u32 FindInstanceGroup(App* app, u32 modelIdx, u32 submeshIdx)
+{
+    InstanceBatches& batches = app->instancing;
+    u64 key = ((u64)modelIdx << 32) | submeshIdx;
+    auto it = batches.groupIndices.find(key);
+    if (it != batches.groupIndices.end())
+        return it->second;
+
+    InstanceGroup group;
+    group.modelIdx = modelIdx;
+    group.submeshIdx = submeshIdx;
+    group.materialIdx = app->models[modelIdx].materialIdx[submeshIdx];
+
+    u32 groupIdx = (u32)batches.groups.size();
+    batches.groups.push_back(group);
+    batches.groupIndices[key] = groupIdx;
+    return groupIdx;
+}
+
+void InitInstancing(App* app)
+{
+    glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &app->storageBufferAlignment);
+    CreateUniformAllocator(app->instanceBuffers, INSTANCE_BLOCK_REGION_SIZE, app->storageBufferAlignment, GL_SHADER_STORAGE_BUFFER);
+    CreateUniformAllocator(app->indirectBuffers, INDIRECT_BLOCK_REGION_SIZE, sizeof(u32), GL_DRAW_INDIRECT_BUFFER);
+
+    //The base instances count from the start of a block, so they go up to all its regions
+    u32 maxInstances = app->instanceBuffers.regionSize * BUFFER_RING_REGIONS / sizeof(InstanceData);
+    std::vector<u32> indices(maxInstances);
+    for (u32 i = 0; i < maxInstances; ++i)
+        indices[i] = i;
+
+    glGenBuffers(1, &app->instancing.instanceIndexBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, app->instancing.instanceIndexBuffer);
+    glBufferData(GL_ARRAY_BUFFER, maxInstances * sizeof(u32), indices.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+//Commands that can share a multi-draw end up next to each other
+static const Submesh& GetGroupSubmesh(App* app, const InstanceGroup& group)
+{
+    return app->meshes[app->models[group.modelIdx].meshIdx].submeshes[group.submeshIdx];
+}
+
+static RenderStateChanges CountStateChanges(App* app, const std::vector<InstanceDraw>& draws)
+{
+    RenderStateChanges changes;
+    if (draws.empty())
+        return changes;
+
+    //Everything is bound for the first draw
+    changes.programs = 1;
+    u32 arenaIdx = UINT32_MAX, textureIdx = UINT32_MAX;
+    GLuint buffer = 0;
+    for (const InstanceDraw& draw : draws)
+    {
+        const InstanceGroup& group = app->instancing.groups[draw.groupIdx];
+        u32 drawArenaIdx = GetGroupSubmesh(app, group).arenaIdx;
+        u32 drawTextureIdx = app->materials[group.materialIdx].albedoTextureIdx;
+        changes.vaos += drawArenaIdx != arenaIdx;
+        changes.textures += drawTextureIdx != textureIdx;
+        changes.instanceBuffers += draw.buffer != buffer;
+        arenaIdx = drawArenaIdx;
+        textureIdx = drawTextureIdx;
+        buffer = draw.buffer;
+    }
+    return changes;
+}
+
+//Sorts the draws by their render queue keys, see render_queue.h
+static void SortInstanceDraws(App* app)
+{
+    InstanceBatches& batches = app->instancing;
+    const u32 drawCount = (u32)batches.draws.size();
+
+    batches.sortKeys.resize(drawCount);
+    batches.sortOrder.resize(drawCount);
+    for (u32 i = 0; i < drawCount; ++i)
+    {
+        const InstanceDraw& draw = batches.draws[i];
+        const InstanceGroup& group = batches.groups[draw.groupIdx];
+        batches.sortKeys[i] = MakeSortKey(RenderPass_Geometry, app->texturedMeshProgramIdx, GetGroupSubmesh(app, group).arenaIdx,
+            app->materials[group.materialIdx].albedoTextureIdx, draw.blockIdx, group.materialIdx, draw.viewDepth);
+        batches.sortOrder[i] = i;
+    }
+    RadixSort(batches.sortKeys, batches.sortOrder, batches.scratchKeys, batches.scratchOrder);
+
+    batches.sortedDraws.resize(drawCount);
+    for (u32 i = 0; i < drawCount; ++i)
+        batches.sortedDraws[i] = batches.draws[batches.sortOrder[i]];
+
+    batches.unsortedStateChanges = CountStateChanges(app, batches.draws);
+    batches.draws.swap(batches.sortedDraws);
+    batches.stateChanges = CountStateChanges(app, batches.draws);
+}
+
+static void PackIndirectCommands(App* app)
+{
+    InstanceBatches& batches = app->instancing;
+    batches.multiDraws.clear();
+    SortInstanceDraws(app);
+
+    for (u32 first = 0; first < batches.draws.size();)
+    {
+        const InstanceDraw& firstDraw = batches.draws[first];
+        const InstanceGroup& firstGroup = batches.groups[firstDraw.groupIdx];
+
+        MultiDraw multiDraw;
+        multiDraw.arenaIdx = GetGroupSubmesh(app, firstGroup).arenaIdx;
+        multiDraw.albedoTextureIdx = app->materials[firstGroup.materialIdx].albedoTextureIdx;
+        multiDraw.instanceBuffer = firstDraw.buffer;
+
+        //Extend the run while the state stays the same and the commands fit in a region
+        const u32 maxCommands = app->indirectBuffers.regionSize / sizeof(DrawElementsIndirectCommand);
+        u32 end = first + 1;
+        while (end < batches.draws.size() && end - first < maxCommands)
+        {
+            const InstanceDraw& draw = batches.draws[end];
+            const InstanceGroup& group = batches.groups[draw.groupIdx];
+            const Submesh& submesh = GetGroupSubmesh(app, group);
+            u32 albedoTextureIdx = app->materials[group.materialIdx].albedoTextureIdx;
+            if (submesh.arenaIdx != multiDraw.arenaIdx || albedoTextureIdx != multiDraw.albedoTextureIdx || draw.buffer != multiDraw.instanceBuffer)
+                break;
+            ++end;
+        }
+
+        multiDraw.commandCount = end - first;
+        Buffer& buffer = ReserveUniforms(app->indirectBuffers, multiDraw.commandCount * sizeof(DrawElementsIndirectCommand));
+        multiDraw.commandBuffer = buffer.handle;
+        multiDraw.commandOffset = buffer.head;
+
+        DrawElementsIndirectCommand* commands = (DrawElementsIndirectCommand*)((u8*)buffer.data + buffer.head);
+        for (u32 i = first; i < end; ++i)
+        {
+            const InstanceDraw& draw = batches.draws[i];
+            const InstanceGroup& group = batches.groups[draw.groupIdx];
+            const Submesh& submesh = GetGroupSubmesh(app, group);
+
+            DrawElementsIndirectCommand& command = commands[i - first];
+            command.count = submesh.indexCount;
+            command.instanceCount = draw.count;
+            command.firstIndex = submesh.firstIndex;
+            command.baseVertex = (i32)submesh.baseVertex;
+            command.baseInstance = draw.firstInstance;
+        }
+        buffer.head += multiDraw.commandCount * sizeof(DrawElementsIndirectCommand);
+
+        batches.multiDraws.push_back(multiDraw);
+        first = end;
+    }
+}
+
+void PackInstances(App* app)
+{
+    PROFILE_SCOPE("PackInstances");
+
+    InstanceBatches& batches = app->instancing;
+    for (InstanceGroup& group : batches.groups)
+        group.entityIndices.clear();
+    batches.draws.clear();
+    batches.instanceCount = 0;
+
+    //--Grouping--
+    const EntityStore& entities = app->entities;
+    for (u32 i = 0; i < entities.count; ++i)
+    {
+        if (!entities.isVisible[i])
+            continue;
+
+        u32 modelIdx = entities.modelIndices[i];
+        u32 submeshCount = (u32)app->meshes[app->models[modelIdx].meshIdx].submeshes.size();
+        const u8* submeshVisibility = &app->cullingBounds.isVisible[entities.firstBoundsIndices[i]];
+        for (u32 j = 0; j < submeshCount; ++j)
+            if (submeshVisibility[j])
+                batches.groups[FindInstanceGroup(app, modelIdx, j)].entityIndices.push_back(i);
+    }
+
+    //--Instance data--
+    //Reserving is serial and fixes where every range goes, then the ranges are written in
+    //parallel. A group larger than a block region is split over several draws.
+    const u32 maxInstancesPerDraw = app->instanceBuffers.regionSize / sizeof(InstanceData);
+    batches.ranges.clear();
+    for (u32 groupIdx = 0; groupIdx < batches.groups.size(); ++groupIdx)
+    {
+        const InstanceGroup& group = batches.groups[groupIdx];
+        for (u32 first = 0; first < group.entityIndices.size(); first += maxInstancesPerDraw)
+        {
+            u32 count = glm::min((u32)group.entityIndices.size() - first, maxInstancesPerDraw);
+            Buffer& buffer = ReserveUniforms(app->instanceBuffers, count * sizeof(InstanceData));
+
+            InstanceDraw draw;
+            draw.groupIdx = groupIdx;
+            draw.buffer = buffer.handle;
+            draw.blockIdx = app->instanceBuffers.usedBlockCount - 1;
+            draw.firstInstance = buffer.head / sizeof(InstanceData);
+            draw.count = count;
+            draw.viewDepth = FLT_MAX;
+
+            InstanceData* instances = (InstanceData*)((u8*)buffer.data + buffer.head);
+            for (u32 offset = 0; offset < count; offset += INSTANCE_RANGE_SIZE)
+            {
+                InstanceRange range;
+                range.instances = instances + offset;
+                range.drawIdx = (u32)batches.draws.size();
+                range.firstEntity = first + offset;
+                range.count = glm::min(count - offset, (u32)INSTANCE_RANGE_SIZE);
+                batches.ranges.push_back(range);
+            }
+
+            batches.draws.push_back(draw);
+            buffer.head += count * sizeof(InstanceData);
+            batches.instanceCount += count;
+        }
+    }
+
+    const glm::mat4 viewProjection = app->camera.projection * app->camera.view;
+    ParallelFor(app->jobs, (u32)batches.ranges.size(), 1, [app, &viewProjection](u32 begin, u32 end)
+    {
+        InstanceBatches& batches = app->instancing;
+        for (u32 i = begin; i < end; ++i)
+        {
+            InstanceRange& range = batches.ranges[i];
+            const InstanceGroup& group = batches.groups[batches.draws[range.drawIdx].groupIdx];
+            range.viewDepth = WriteInstances(range.instances, app->entities.worldMatrices.data(), &group.entityIndices[range.firstEntity],
+                range.count, viewProjection, group.materialIdx);
+        }
+    });
+    for (const InstanceRange& range : batches.ranges)
+        batches.draws[range.drawIdx].viewDepth = glm::min(batches.draws[range.drawIdx].viewDepth, range.viewDepth);
+
+    PackIndirectCommands(app);
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+#include "platform.h"
+#include <glad/glad.h>
+#include "render_queue.h"
+#include <unordered_map>
+
+//Hardware instancing of the geometry pass. Every frame the visible entity submeshes are
+//grouped by (model, submesh), which also fixes the material, and the world/MVP matrices of
+//each group are written contiguously to a shader storage buffer. The groups then become
+//indirect draw commands, and the commands sharing a mesh arena, an albedo texture and a
+//storage block are submitted with a single glMultiDrawElementsIndirect. The vertex shader
+//finds its matrices and material through the instance index input, which is offset by
+//each command's base instance.
+
+#define INSTANCE_INDEX_LOCATION 7
+#define INSTANCE_RANGE_SIZE 512 //Instances written by one job at most
+
+struct App;
+
+//std430 layout of an instance. The world matrix is affine, so only its first three rows
+//are stored, leaving room for the material index in 128 bytes.
+struct InstanceData
+{
+    glm::vec4 worldRows[3];
+    glm::mat4 MVP;
+    u32 materialIdx;
+    u32 padding[3];
+};
+
+struct InstanceGroup
+{
+    u32 modelIdx = 0;
+    u32 submeshIdx = 0;
+    u32 materialIdx = 0;
+    std::vector<u32> entityIndices; //Visible this frame
+};
+
+//A range of a group's instances living in one storage buffer block
+struct InstanceDraw
+{
+    u32 groupIdx = 0;
+    GLuint buffer = 0;
+    u32 blockIdx = 0;      //Of the buffer in App::instanceBuffers
+    u32 firstInstance = 0; //From the start of the buffer
+    u32 count = 0;
+    f32 viewDepth = 0.0f;  //Of the nearest instance origin
+};
+
+//A slice of a draw's instances, its place in the storage block fixed before any is written
+struct InstanceRange
+{
+    InstanceData* instances = nullptr;
+    u32 drawIdx = 0;
+    u32 firstEntity = 0;  //Into the group's entity indices
+    u32 count = 0;
+    f32 viewDepth = 0.0f; //Of the nearest instance origin
+};
+
+struct DrawElementsIndirectCommand
+{
+    u32 count;
+    u32 instanceCount;
+    u32 firstIndex;
+    i32 baseVertex;
+    u32 baseInstance;
+};
+
+//Consecutive indirect commands drawn with the same state. Materials come from the
+//instance data, only their albedo texture splits the runs.
+struct MultiDraw
+{
+    u32 arenaIdx = 0;
+    u32 albedoTextureIdx = 0;
+    GLuint instanceBuffer = 0;
+    GLuint commandBuffer = 0;
+    u32 commandOffset = 0;
+    u32 commandCount = 0;
+};
+
+struct InstanceBatches
+{
+    //Groups are kept between frames so their entity lists reuse their memory
+    std::unordered_map<u64, u32> groupIndices;
+    std::vector<InstanceGroup> groups;
+    std::vector<InstanceDraw> draws;
+    std::vector<InstanceRange> ranges;
+    std::vector<MultiDraw> multiDraws;
+    u32 instanceCount = 0;
+
+    //Render queue: the draws are submitted in the order of their sort keys
+    std::vector<u64> sortKeys, scratchKeys;
+    std::vector<u32> sortOrder, scratchOrder;
+    std::vector<InstanceDraw> sortedDraws;
+    RenderStateChanges stateChanges;         //Between the sorted draws
+    RenderStateChanges unsortedStateChanges; //The draws would need in grouping order
+
+    //0, 1, 2... up to the instances of a whole storage block, read with a divisor of 1
+    GLuint instanceIndexBuffer = 0;
+};
+
+/**
+ * Creates the storage blocks for the instance data, the indirect command blocks and the
+ * instance index buffer.
+ */
+void InitInstancing(App* app);
+
+/**
+ * Groups the entity submeshes flagged visible by CullEntities and writes their instance
+ * data to App::instanceBuffers, in parallel over App::jobs, and their draw commands to
+ * App::indirectBuffers, both of which must be between BeginUniformWrites and
+ * EndUniformWrites. Fills App::instancing.multiDraws for the geometry pass.
+ */
+void PackInstances(App* app);
@@ -0,0 +1,200 @@
+#include "job_system.h"
+#include "profiler.h"
+#include <stdio.h>
+
+//Queue of the calling thread in the system it is a worker of. Any other system, or a thread
+//that is no worker, uses queue 0, shared with the creator.
+static thread_local const JobSystem* t_workerSystem = NULL;
+static thread_local u32 t_queueIdx = 0;
+
+static u32 GetQueueIdx(const JobSystem& system)
+{
+    return t_workerSystem == &system ? t_queueIdx : 0;
+}
+
+u32 GetDefaultWorkerCount()
+{
+    u32 hardwareThreads = std::thread::hardware_concurrency();
+    return hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+}
+
+//With a counter, only a job of that counter is taken, the closest one to the end popped from
+static bool PopJob(JobQueue& queue, Job& job, bool fromBack, const JobCounter* counter)
+{
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.jobs.empty())
+        return false;
+
+    if (!counter)
+    {
+        if (fromBack)
+        {
+            job = std::move(queue.jobs.back());
+            queue.jobs.pop_back();
+        }
+        else
+        {
+            job = std::move(queue.jobs.front());
+            queue.jobs.pop_front();
+        }
+        return true;
+    }
+
+    const size_t jobCount = queue.jobs.size();
+    for (size_t n = 0; n < jobCount; ++n)
+    {
+        size_t i = fromBack ? jobCount - 1 - n : n;
+        if (queue.jobs[i].counter == counter)
+        {
+            job = std::move(queue.jobs[i]);
+            queue.jobs.erase(queue.jobs.begin() + i);
+            return true;
+        }
+    }
+    return false;
+}
+
+//Own queue first, then steal from the others starting at the next one
+static bool FindJob(JobSystem& system, u32 queueIdx, Job& job, const JobCounter* counter)
+{
+    if (system.queuedJobs.load(std::memory_order_relaxed) == 0)
+        return false;
+
+    for (u32 i = 0; i < system.threadCount; ++i)
+    {
+        u32 victimIdx = (queueIdx + i) % system.threadCount;
+        if (PopJob(system.queues[victimIdx], job, victimIdx == queueIdx, counter))
+        {
+            system.queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+static void ExecuteJob(Job& job)
+{
+    PROFILE_SCOPE("Job");
+    job.function();
+    if (job.counter)
+        job.counter->pending.fetch_sub(1, std::memory_order_acq_rel);
+}
+
+static void WorkerLoop(JobSystem* system, u32 queueIdx)
+{
+    t_workerSystem = system;
+    t_queueIdx = queueIdx;
+    char threadName[32];
+    snprintf(threadName, sizeof(threadName), "Job worker %u", queueIdx);
+    SetProfilerThreadName(threadName);
+
+    while (!system->stopping.load())
+    {
+        Job job;
+        if (FindJob(*system, queueIdx, job, NULL))
+        {
+            ExecuteJob(job);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(system->sleepMutex);
+        system->jobAvailable.wait(lock, [system] { return system->stopping.load() || system->queuedJobs.load() > 0; });
+    }
+}
+
+void CreateJobSystem(JobSystem& system, u32 workerCount)
+{
+    ASSERT(system.workers.empty(), "Job system already created");
+
+    system.threadCount = workerCount + 1;
+    system.queues.reset(new JobQueue[system.threadCount]);
+    system.queuedJobs = 0;
+    system.stopping = false;
+
+    system.workers.reserve(workerCount);
+    for (u32 i = 0; i < workerCount; ++i)
+        system.workers.push_back(std::thread(WorkerLoop, &system, i + 1));
+}
+
+void DestroyJobSystem(JobSystem& system)
+{
+    {
+        std::lock_guard<std::mutex> lock(system.sleepMutex);
+        system.stopping = true;
+    }
+    system.jobAvailable.notify_all();
+
+    for (std::thread& worker : system.workers)
+        worker.join();
+    system.workers.clear();
+    system.queues.reset();
+    system.threadCount = 0;
+}
+
+void RunJob(JobSystem& system, JobFunction function, JobCounter* counter)
+{
+    if (counter)
+        counter->pending.fetch_add(1, std::memory_order_relaxed);
+
+    //Counted before it is queued so a thief popping it right away never takes the count
+    //below zero: queuedJobs is at least the number of queued jobs at all times
+    system.queuedJobs.fetch_add(1, std::memory_order_relaxed);
+    u32 queueIdx = GetQueueIdx(system);
+    {
+        std::lock_guard<std::mutex> lock(system.queues[queueIdx].mutex);
+        system.queues[queueIdx].jobs.push_back(Job{ std::move(function), counter });
+    }
+
+    //Taking the lock orders this with a worker about to sleep, so the wake up is not lost
+    if (!system.workers.empty())
+    {
+        { std::lock_guard<std::mutex> lock(system.sleepMutex); }
+        system.jobAvailable.notify_one();
+    }
+}
+
+void WaitForCounter(JobSystem& system, JobCounter& counter)
+{
+    //Only the jobs being waited on: a long background job (a texture decode...) picked up here
+    //would stall the waiting thread, usually the main one, far past the end of its own work
+    u32 queueIdx = GetQueueIdx(system);
+    while (counter.pending.load(std::memory_order_acquire) > 0)
+    {
+        Job job;
+        if (FindJob(system, queueIdx, job, &counter))
+            ExecuteJob(job);
+        else
+            std::this_thread::yield();
+    }
+}
+
+void ParallelFor(JobSystem& system, u32 count, u32 minRangeSize, const std::function<void(u32, u32)>& function)
+{
+    if (count == 0)
+        return;
+
+    //A few ranges per thread so the stealing can even out uneven ranges
+    if (minRangeSize == 0)
+        minRangeSize = 1;
+    u32 rangeCount = system.threadCount * 4;
+    u32 maxRangeCount = (count + minRangeSize - 1) / minRangeSize;
+    if (rangeCount > maxRangeCount)
+        rangeCount = maxRangeCount;
+    if (rangeCount <= 1)
+    {
+        function(0, count);
+        return;
+    }
+
+    JobCounter counter;
+    u32 rangeSize = (count + rangeCount - 1) / rangeCount;
+    for (u32 begin = rangeSize; begin < count; begin += rangeSize)
+    {
+        u32 end = begin + rangeSize < count ? begin + rangeSize : count;
+        RunJob(system, [&function, begin, end] { function(begin, end); }, &counter);
+    }
+
+    //The caller takes the first range itself
+    function(0, rangeSize < count ? rangeSize : count);
+    WaitForCounter(system, counter);
+}
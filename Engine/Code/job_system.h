@@ -0,0 +1,86 @@
+#pragma once
+
+#include "platform.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+//Work-stealing job system for the per-frame engine work. Every thread owns a deque of jobs:
+//it pushes and pops its own jobs at the back, while idle threads steal from the front of
+//the others' deques, so a thread works on its freshest (cache-warm) jobs and the oldest,
+//usually biggest, ones migrate. The thread that creates the system is thread 0 and helps
+//running the jobs of a counter whenever it waits on it, so a system with no workers still works.
+//Jobs are meant for CPU-only work (decoding, parsing, transforms...): they must never touch
+//the OpenGL context, which stays current on the main thread only.
+
+typedef std::function<void()> JobFunction;
+
+/**
+ * Number of jobs still to finish. Jobs are attached to a counter when they are started and
+ * waiting on it is how later work depends on them.
+ */
+struct JobCounter
+{
+    std::atomic<u32> pending{0};
+};
+
+struct Job
+{
+    JobFunction function;
+    JobCounter* counter = NULL;
+};
+
+struct JobQueue
+{
+    std::mutex mutex;
+    std::deque<Job> jobs;
+};
+
+struct JobSystem
+{
+    std::vector<std::thread> workers;
+    std::unique_ptr<JobQueue[]> queues; //One per thread, workers first at index 1
+    u32 threadCount = 0;
+
+    std::atomic<u32> queuedJobs{0};
+    std::atomic<bool> stopping{false};
+    std::mutex sleepMutex;
+    std::condition_variable jobAvailable;
+};
+
+/**
+ * Number of workers to use when the caller has no preference: one per hardware thread,
+ * leaving the main thread its own core.
+ */
+u32 GetDefaultWorkerCount();
+
+/**
+ * Spawns workerCount threads. GetDefaultWorkerCount gives one per spare hardware thread.
+ */
+void CreateJobSystem(JobSystem& system, u32 workerCount);
+
+/**
+ * Joins the workers. Every counter must have been waited on before.
+ */
+void DestroyJobSystem(JobSystem& system);
+
+/**
+ * Queues a job on the calling thread's deque and adds it to the counter, which may be NULL.
+ */
+void RunJob(JobSystem& system, JobFunction function, JobCounter* counter);
+
+/**
+ * Returns once every job of the counter has finished, running its queued jobs meanwhile.
+ * Jobs of other counters, or of none, are left to the workers.
+ */
+void WaitForCounter(JobSystem& system, JobCounter& counter);
+
+/**
+ * Calls function(begin, end) over [0, count) split into ranges of at least minRangeSize
+ * elements, spread over all the threads, and waits for all of them.
+ */
+void ParallelFor(JobSystem& system, u32 count, u32 minRangeSize, const std::function<void(u32, u32)>& function);
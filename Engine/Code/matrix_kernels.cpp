@@ -0,0 +1,179 @@
+#include "matrix_kernels.h"
+
+#if defined(__AVX2__)
+#define MATRIX_KERNELS_USE_AVX2 1
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MATRIX_KERNELS_USE_SSE 1
+#include <emmintrin.h>
+#endif
+
+const char* GetMatrixKernelsISA()
+{
+#if defined(MATRIX_KERNELS_USE_AVX2)
+    return "AVX2";
+#elif defined(MATRIX_KERNELS_USE_SSE)
+    return "SSE2";
+#else
+    return "Scalar";
+#endif
+}
+
+//--Arrays of matrices--
+//Every result column is the left columns weighted by the elements of a right column
+void MultiplyMatrices(const glm::mat4& left, const glm::mat4* rights, glm::mat4* results, u32 count)
+{
+#if defined(MATRIX_KERNELS_USE_AVX2)
+    //Two result columns per register: the left columns are repeated in both halves and
+    //the in-lane permutes broadcast the elements of each right column to its own half
+    const __m256 left0 = _mm256_broadcast_ps((const __m128*)&left[0][0]);
+    const __m256 left1 = _mm256_broadcast_ps((const __m128*)&left[1][0]);
+    const __m256 left2 = _mm256_broadcast_ps((const __m128*)&left[2][0]);
+    const __m256 left3 = _mm256_broadcast_ps((const __m128*)&left[3][0]);
+
+    for (u32 i = 0; i < count; ++i)
+    {
+        const f32* right = &rights[i][0][0];
+        f32* result = &results[i][0][0];
+        for (u32 c = 0; c < 4; c += 2)
+        {
+            __m256 columns = _mm256_loadu_ps(right + c * 4);
+            __m256 sum = _mm256_mul_ps(left0, _mm256_permute_ps(columns, _MM_SHUFFLE(0, 0, 0, 0)));
+            sum = _mm256_add_ps(sum, _mm256_mul_ps(left1, _mm256_permute_ps(columns, _MM_SHUFFLE(1, 1, 1, 1))));
+            sum = _mm256_add_ps(sum, _mm256_mul_ps(left2, _mm256_permute_ps(columns, _MM_SHUFFLE(2, 2, 2, 2))));
+            sum = _mm256_add_ps(sum, _mm256_mul_ps(left3, _mm256_permute_ps(columns, _MM_SHUFFLE(3, 3, 3, 3))));
+            _mm256_storeu_ps(result + c * 4, sum);
+        }
+    }
+#elif defined(MATRIX_KERNELS_USE_SSE)
+    const __m128 left0 = _mm_loadu_ps(&left[0][0]);
+    const __m128 left1 = _mm_loadu_ps(&left[1][0]);
+    const __m128 left2 = _mm_loadu_ps(&left[2][0]);
+    const __m128 left3 = _mm_loadu_ps(&left[3][0]);
+
+    for (u32 i = 0; i < count; ++i)
+    {
+        const f32* right = &rights[i][0][0];
+        f32* result = &results[i][0][0];
+        for (u32 c = 0; c < 4; ++c)
+        {
+            __m128 column = _mm_loadu_ps(right + c * 4);
+            __m128 sum = _mm_mul_ps(left0, _mm_shuffle_ps(column, column, _MM_SHUFFLE(0, 0, 0, 0)));
+            sum = _mm_add_ps(sum, _mm_mul_ps(left1, _mm_shuffle_ps(column, column, _MM_SHUFFLE(1, 1, 1, 1))));
+            sum = _mm_add_ps(sum, _mm_mul_ps(left2, _mm_shuffle_ps(column, column, _MM_SHUFFLE(2, 2, 2, 2))));
+            sum = _mm_add_ps(sum, _mm_mul_ps(left3, _mm_shuffle_ps(column, column, _MM_SHUFFLE(3, 3, 3, 3))));
+            _mm_storeu_ps(result + c * 4, sum);
+        }
+    }
+#else
+    for (u32 i = 0; i < count; ++i)
+        results[i] = left * rights[i];
+#endif
+}
+
+//--Blocks of matrices--
+//Every element of a block is a vector over its matrices, multiplied by a broadcast element
+//of the left matrix
+void MultiplyMatrixBlocks(const glm::mat4& left, const MatrixBlock* rights, MatrixBlock* results, u32 blockCount)
+{
+#if defined(MATRIX_KERNELS_USE_AVX2)
+    __m256 leftElements[16];
+    for (u32 e = 0; e < 16; ++e)
+        leftElements[e] = _mm256_set1_ps(left[e / 4][e % 4]);
+
+    for (u32 b = 0; b < blockCount; ++b)
+    {
+        const MatrixBlock& right = rights[b];
+        __m256 sums[16];
+        for (u32 c = 0; c < 4; ++c)
+        {
+            __m256 right0 = _mm256_loadu_ps(right.elements[c * 4 + 0]);
+            __m256 right1 = _mm256_loadu_ps(right.elements[c * 4 + 1]);
+            __m256 right2 = _mm256_loadu_ps(right.elements[c * 4 + 2]);
+            __m256 right3 = _mm256_loadu_ps(right.elements[c * 4 + 3]);
+            for (u32 r = 0; r < 4; ++r)
+            {
+                __m256 sum = _mm256_mul_ps(leftElements[0 * 4 + r], right0);
+                sum = _mm256_add_ps(sum, _mm256_mul_ps(leftElements[1 * 4 + r], right1));
+                sum = _mm256_add_ps(sum, _mm256_mul_ps(leftElements[2 * 4 + r], right2));
+                sum = _mm256_add_ps(sum, _mm256_mul_ps(leftElements[3 * 4 + r], right3));
+                sums[c * 4 + r] = sum;
+            }
+        }
+        //Stored once the whole block is read, since results may alias rights
+        for (u32 e = 0; e < 16; ++e)
+            _mm256_storeu_ps(results[b].elements[e], sums[e]);
+    }
+#elif defined(MATRIX_KERNELS_USE_SSE)
+    __m128 leftElements[16];
+    for (u32 e = 0; e < 16; ++e)
+        leftElements[e] = _mm_set1_ps(left[e / 4][e % 4]);
+
+    for (u32 b = 0; b < blockCount; ++b)
+    {
+        const MatrixBlock& right = rights[b];
+        MatrixBlock& result = results[b];
+        for (u32 half = 0; half < MATRIX_BLOCK_WIDTH; half += 4)
+        {
+            __m128 sums[16];
+            for (u32 c = 0; c < 4; ++c)
+            {
+                __m128 right0 = _mm_loadu_ps(&right.elements[c * 4 + 0][half]);
+                __m128 right1 = _mm_loadu_ps(&right.elements[c * 4 + 1][half]);
+                __m128 right2 = _mm_loadu_ps(&right.elements[c * 4 + 2][half]);
+                __m128 right3 = _mm_loadu_ps(&right.elements[c * 4 + 3][half]);
+                for (u32 r = 0; r < 4; ++r)
+                {
+                    __m128 sum = _mm_mul_ps(leftElements[0 * 4 + r], right0);
+                    sum = _mm_add_ps(sum, _mm_mul_ps(leftElements[1 * 4 + r], right1));
+                    sum = _mm_add_ps(sum, _mm_mul_ps(leftElements[2 * 4 + r], right2));
+                    sum = _mm_add_ps(sum, _mm_mul_ps(leftElements[3 * 4 + r], right3));
+                    sums[c * 4 + r] = sum;
+                }
+            }
+            for (u32 e = 0; e < 16; ++e)
+                _mm_storeu_ps(&result.elements[e][half], sums[e]);
+        }
+    }
+#else
+    for (u32 b = 0; b < blockCount; ++b)
+    {
+        const MatrixBlock& right = rights[b];
+        MatrixBlock result;
+        for (u32 c = 0; c < 4; ++c)
+            for (u32 r = 0; r < 4; ++r)
+                for (u32 m = 0; m < MATRIX_BLOCK_WIDTH; ++m)
+                    result.elements[c * 4 + r][m] =
+                        left[0][r] * right.elements[c * 4 + 0][m] +
+                        left[1][r] * right.elements[c * 4 + 1][m] +
+                        left[2][r] * right.elements[c * 4 + 2][m] +
+                        left[3][r] * right.elements[c * 4 + 3][m];
+        results[b] = result;
+    }
+#endif
+}
+
+void PackMatrixBlocks(const glm::mat4* matrices, u32 count, MatrixBlock* blocks)
+{
+    u32 blockCount = (count + MATRIX_BLOCK_WIDTH - 1) / MATRIX_BLOCK_WIDTH;
+    for (u32 b = 0; b < blockCount; ++b)
+    {
+        for (u32 m = 0; m < MATRIX_BLOCK_WIDTH; ++m)
+        {
+            u32 i = b * MATRIX_BLOCK_WIDTH + m;
+            const glm::mat4 matrix = i < count ? matrices[i] : glm::mat4(1.0f);
+            for (u32 e = 0; e < 16; ++e)
+                blocks[b].elements[e][m] = matrix[e / 4][e % 4];
+        }
+    }
+}
+
+void UnpackMatrixBlocks(const MatrixBlock* blocks, u32 count, glm::mat4* matrices)
+{
+    for (u32 i = 0; i < count; ++i)
+    {
+        const MatrixBlock& block = blocks[i / MATRIX_BLOCK_WIDTH];
+        for (u32 e = 0; e < 16; ++e)
+            matrices[i][e / 4][e % 4] = block.elements[e][i % MATRIX_BLOCK_WIDTH];
+    }
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "platform.h"
+
+//Batch matrix products for the per entity transforms: one shared matrix (the view
+//projection) times an array of matrices (the world matrices). The widest instruction set
+//the build targets is used: AVX2 when compiled for it (ENGINE_ENABLE_AVX2 or
+//ENGINE_NATIVE_ARCH), SSE2 otherwise, plain C++ when neither is there.
+//Every path sums in the same order as glm's operator*, so all of them give the same bits.
+//
+//Besides arrays of glm::mat4 the kernels take an AoSoA layout: blocks of MATRIX_BLOCK_WIDTH
+//matrices with each element stored as MATRIX_BLOCK_WIDTH consecutive floats, one per matrix,
+//which lets a whole block be multiplied without any shuffling.
+
+#define MATRIX_BLOCK_WIDTH 8
+
+struct MatrixBlock
+{
+    f32 elements[16][MATRIX_BLOCK_WIDTH]; //[column * 4 + row][matrix]
+};
+
+/**
+ * Name of the instruction set the kernels were compiled for.
+ */
+const char* GetMatrixKernelsISA();
+
+/**
+ * results[i] = left * rights[i] for i in [0, count). results may alias rights.
+ */
+void MultiplyMatrices(const glm::mat4& left, const glm::mat4* rights, glm::mat4* results, u32 count);
+
+/**
+ * Same as MultiplyMatrices over blockCount blocks of MATRIX_BLOCK_WIDTH matrices.
+ */
+void MultiplyMatrixBlocks(const glm::mat4& left, const MatrixBlock* rights, MatrixBlock* results, u32 blockCount);
+
+/**
+ * Converts between arrays of matrices and blocks. The last block is padded with identity
+ * matrices when count is not a multiple of MATRIX_BLOCK_WIDTH, and blocks must have room
+ * for (count + MATRIX_BLOCK_WIDTH - 1) / MATRIX_BLOCK_WIDTH blocks.
+ */
+void PackMatrixBlocks(const glm::mat4* matrices, u32 count, MatrixBlock* blocks);
+void UnpackMatrixBlocks(const MatrixBlock* blocks, u32 count, glm::mat4* matrices);
@@ -0,0 +1,157 @@
+#include "mesh_arena.h"
+#include "engine.h"
+
+static bool AreLayoutsEqual(const VertexBufferLayout& a, const VertexBufferLayout& b)
+{
+    if (a.stride != b.stride || a.attributes.size() != b.attributes.size())
+        return false;
+
+    for (u32 i = 0; i < a.attributes.size(); ++i)
+    {
+        if (a.attributes[i].location != b.attributes[i].location ||
+            a.attributes[i].componentCount != b.attributes[i].componentCount ||
+            a.attributes[i].offset != b.attributes[i].offset)
+            return false;
+    }
+    return true;
+}
+
+//The copy targets are used for every arena upload so the element array binding of
+//whichever VAO is bound is never touched
+static GLuint CreateArenaBuffer(u32 capacity)
+{
+    GLuint handle = 0;
+    glGenBuffers(1, &handle);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, handle);
+    glBufferData(GL_COPY_WRITE_BUFFER, capacity, NULL, GL_STATIC_DRAW);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    return handle;
+}
+
+//Moves the contents to a buffer of the new capacity. The VAOs referencing the old one are
+//dropped and rebuilt on their next use.
+static void GrowArenaBuffer(MeshArena& arena, GLuint& handle, u32& capacity, u32 size, u32 requiredCapacity)
+{
+    u32 newCapacity = capacity;
+    while (newCapacity < requiredCapacity)
+        newCapacity *= 2;
+
+    GLuint newHandle = CreateArenaBuffer(newCapacity);
+    glBindBuffer(GL_COPY_READ_BUFFER, handle);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, newHandle);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, size);
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    glDeleteBuffers(1, &handle);
+
+    handle = newHandle;
+    capacity = newCapacity;
+    for (const VAO& vao : arena.vaos)
+        glDeleteVertexArrays(1, &vao.handle);
+    arena.vaos.clear();
+}
+
+u32 FindMeshArena(App* app, const VertexBufferLayout& layout)
+{
+    for (u32 i = 0; i < app->meshArenas.size(); ++i)
+        if (AreLayoutsEqual(app->meshArenas[i].layout, layout))
+            return i;
+
+    MeshArena arena;
+    arena.layout = layout;
+    arena.vertexCapacity = MESH_ARENA_VERTEX_CAPACITY;
+    arena.indexCapacity = MESH_ARENA_INDEX_CAPACITY;
+    arena.vertexBufferHandle = CreateArenaBuffer(arena.vertexCapacity);
+    arena.indexBufferHandle = CreateArenaBuffer(arena.indexCapacity);
+    app->meshArenas.push_back(arena);
+    return (u32)app->meshArenas.size() - 1u;
+}
+
+MeshArenaAllocation UploadToMeshArena(App* app, const VertexBufferLayout& layout,
+    const void* vertices, u32 vertexSize, const void* indices, u32 indexSize)
+{
+    ASSERT(layout.stride > 0 && vertexSize % layout.stride == 0, "The vertex data does not match its layout");
+
+    MeshArenaAllocation allocation;
+    allocation.arenaIdx = FindMeshArena(app, layout);
+    MeshArena& arena = app->meshArenas[allocation.arenaIdx];
+
+    if (arena.vertexSize + vertexSize > arena.vertexCapacity)
+        GrowArenaBuffer(arena, arena.vertexBufferHandle, arena.vertexCapacity, arena.vertexSize, arena.vertexSize + vertexSize);
+    if (arena.indexSize + indexSize > arena.indexCapacity)
+        GrowArenaBuffer(arena, arena.indexBufferHandle, arena.indexCapacity, arena.indexSize, arena.indexSize + indexSize);
+
+    allocation.baseVertex = arena.vertexSize / layout.stride;
+    allocation.firstIndex = arena.indexSize / sizeof(u32);
+
+    glBindBuffer(GL_COPY_WRITE_BUFFER, arena.vertexBufferHandle);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, arena.vertexSize, vertexSize, vertices);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, arena.indexBufferHandle);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, arena.indexSize, indexSize, indices);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    arena.vertexSize += vertexSize;
+    arena.indexSize += indexSize;
+    return allocation;
+}
+
+GLuint FindMeshArenaVAO(App* app, u32 arenaIdx, const Program& program)
+{
+    MeshArena& arena = app->meshArenas[arenaIdx];
+
+    //Try finding a vao for this arena/program
+    for (u32 i = 0; i < (u32)arena.vaos.size(); ++i)
+    {
+        if (arena.vaos[i].programHandle == program.handle)
+            return arena.vaos[i].handle;
+    }
+
+    GLuint vaoHandle = 0;
+    //Create a new VAO for this arena/program
+    {
+        glGenVertexArrays(1, &vaoHandle);
+        glBindVertexArray(vaoHandle);
+
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, arena.indexBufferHandle);
+
+        //We have to link all vertex inputs attributes to attributes in the vertex buffer
+        for (u32 i = 0; i < program.vertexInputLayout.attributes.size(); ++i)
+        {
+            const u32 location = program.vertexInputLayout.attributes[i].location;
+            if (location == INSTANCE_INDEX_LOCATION)
+            {
+                //One value per instance, offset by each draw's base instance
+                glBindBuffer(GL_ARRAY_BUFFER, app->instancing.instanceIndexBuffer);
+                glVertexAttribIPointer(location, 1, GL_UNSIGNED_INT, sizeof(u32), (void*)0);
+                glVertexAttribDivisor(location, 1);
+                glEnableVertexAttribArray(location);
+                continue;
+            }
+
+            bool attributeWasLinked = false;
+            glBindBuffer(GL_ARRAY_BUFFER, arena.vertexBufferHandle);
+            for (u32 j = 0; j < arena.layout.attributes.size(); ++j)
+            {
+                //The arena should provide an attribute for each vertex inputs
+                const VertexBufferAttribute& attribute = arena.layout.attributes[j];
+                if (location == attribute.location)
+                {
+                    glVertexAttribPointer(location, attribute.componentCount, GL_FLOAT, GL_FALSE, arena.layout.stride, (void*)(u64)attribute.offset);
+                    glEnableVertexAttribArray(location);
+
+                    attributeWasLinked = true;
+                    break;
+                }
+            }
+            ASSERT(attributeWasLinked, "The vertex format lacks an input of the program");
+            (void)attributeWasLinked; //Only read by the assert
+        }
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    //Store it in the list of vaos for this arena
+    VAO vao = { vaoHandle, program.handle };
+    arena.vaos.push_back(vao);
+    return vaoHandle;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "platform.h"
+#include "BufferObjects.h"
+#include <glad/glad.h>
+
+//Static geometry is sub-allocated from one large vertex buffer and one large index buffer
+//per vertex format, so every submesh of that format is drawn through the same VAO and
+//whole groups of them can be submitted with a single glMultiDrawElementsIndirect. Indices
+//stay relative to their submesh; the draws add the submesh's base vertex.
+
+#define MESH_ARENA_VERTEX_CAPACITY MB(16)
+#define MESH_ARENA_INDEX_CAPACITY MB(4)
+
+struct App;
+struct Program;
+
+struct MeshArena
+{
+    VertexBufferLayout layout;
+    GLuint vertexBufferHandle = 0;
+    GLuint indexBufferHandle = 0;
+    u32 vertexCapacity = 0; //In bytes
+    u32 vertexSize = 0;
+    u32 indexCapacity = 0;
+    u32 indexSize = 0;
+    std::vector<VAO> vaos; //One per program drawing from it
+};
+
+struct MeshArenaAllocation
+{
+    u32 arenaIdx = 0;
+    u32 baseVertex = 0;
+    u32 firstIndex = 0;
+};
+
+/**
+ * Returns the arena holding the given vertex format, creating it if there is none yet.
+ */
+u32 FindMeshArena(App* app, const VertexBufferLayout& layout);
+
+/**
+ * Appends a submesh's vertices and 32 bit indices to the arena of its vertex format. The
+ * arena buffers grow, copying their contents on the GPU, when they run out of space.
+ */
+MeshArenaAllocation UploadToMeshArena(App* app, const VertexBufferLayout& layout,
+    const void* vertices, u32 vertexSize, const void* indices, u32 indexSize);
+
+/**
+ * Returns the VAO linking the arena's vertex format to the program's vertex inputs,
+ * creating it on first use. The instance index input, see instancing.h, is fed from
+ * App::instancing.instanceIndexBuffer.
+ */
+GLuint FindMeshArenaVAO(App* app, u32 arenaIdx, const Program& program);
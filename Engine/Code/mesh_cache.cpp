@@ -0,0 +1,301 @@
+#include "mesh_cache.h"
+#include "engine.h"
+#include <sstream>
+#include <string.h>
+
+static std::string GetMeshCachePath(const char* filename)
+{
+    return std::string(filename) + MESH_CACHE_EXTENSION;
+}
+
+static bool IsObjFile(const char* filename)
+{
+    size_t length = strlen(filename);
+    return length >= 4 && (strcmp(filename + length - 4, ".obj") == 0 || strcmp(filename + length - 4, ".OBJ") == 0);
+}
+
+//The material table of an OBJ comes from the libraries named by its mtllib lines. Their names
+//are hashed along with their contents, so creating a missing library changes the hash too
+static u64 HashObjMaterialLibraries(const char* filename, const MappedFile& source, u64 hash)
+{
+    String directory = GetDirectoryPart(MakeString(filename));
+    std::string text((const char*)source.data, (size_t)source.size);
+    for (size_t lineStart = 0; lineStart < text.size();)
+    {
+        size_t lineEnd = text.find_first_of("\r\n", lineStart);
+        if (lineEnd == std::string::npos)
+            lineEnd = text.size();
+
+        if (text.compare(lineStart, 7, "mtllib ") == 0 || text.compare(lineStart, 7, "mtllib\t") == 0)
+        {
+            std::istringstream libraries(text.substr(lineStart + 7, lineEnd - lineStart - 7));
+            for (std::string library; libraries >> library;)
+            {
+                hash = HashBytes(library.data(), library.size(), hash);
+                String filepath = MakePath(directory, MakeString(library.c_str()));
+                MappedFile libraryFile = MapFile(filepath.str);
+                if (libraryFile.data)
+                {
+                    hash = HashBytes(libraryFile.data, libraryFile.size, hash);
+                    UnmapFile(libraryFile);
+                }
+            }
+        }
+        lineStart = lineEnd + 1;
+    }
+    return hash;
+}
+
+u64 HashModelSource(const char* filename)
+{
+    MappedFile source = MapFile(filename);
+    if (!source.data)
+        return 0;
+
+    u64 hash = HashBytes(source.data, source.size);
+    if (IsObjFile(filename))
+        hash = HashObjMaterialLibraries(filename, source, hash);
+    UnmapFile(source);
+    return hash != 0 ? hash : 1;
+}
+
+void LoadCachedMaterials(App* app, const MeshCacheMaterial* cacheMaterials, u32 count, String directory, Material* materials)
+{
+    std::vector<const char*> texturePaths;
+    std::vector<u32*> textureSlots;
+
+    for (u32 i = 0; i < count; ++i)
+    {
+        const MeshCacheMaterial& cacheMaterial = cacheMaterials[i];
+        Material& material = materials[i];
+
+        material.name = cacheMaterial.name;
+        material.albedo = vec3(cacheMaterial.albedo[0], cacheMaterial.albedo[1], cacheMaterial.albedo[2]);
+        material.emissive = vec3(cacheMaterial.emissive[0], cacheMaterial.emissive[1], cacheMaterial.emissive[2]);
+        material.specular = vec3(cacheMaterial.specular[0], cacheMaterial.specular[1], cacheMaterial.specular[2]);
+        material.smoothness = cacheMaterial.smoothness;
+
+        u32* textureIndices[MeshCacheTexture_Count] = {
+            &material.albedoTextureIdx,
+            &material.emissiveTextureIdx,
+            &material.specularTextureIdx,
+            &material.normalsTextureIdx,
+            &material.bumpTextureIdx
+        };
+
+        for (u32 slot = 0; slot < MeshCacheTexture_Count; ++slot)
+        {
+            if (cacheMaterial.textures[slot][0] == '\0')
+                continue;
+
+            String filename = MakeString(cacheMaterial.textures[slot]);
+            String filepath = MakePath(directory, filename);
+            texturePaths.push_back(filepath.str);
+            textureSlots.push_back(textureIndices[slot]);
+        }
+    }
+
+    std::vector<u32> loadedIndices(texturePaths.size());
+    LoadTextures2D(app, texturePaths.data(), (u32)texturePaths.size(), loadedIndices.data());
+    for (u32 i = 0; i < textureSlots.size(); ++i)
+        *textureSlots[i] = loadedIndices[i];
+}
+
+static u64 GetMeshCacheSize(const MeshCacheHeader& header, u64* vertexDataOffset, u64* indexDataOffset)
+{
+    const u64 submeshesOffset = sizeof(MeshCacheHeader);
+    const u64 materialsOffset = submeshesOffset + (u64)header.submeshCount * sizeof(MeshCacheSubmesh);
+    *vertexDataOffset = materialsOffset + (u64)header.materialCount * sizeof(MeshCacheMaterial);
+    *indexDataOffset = *vertexDataOffset + header.vertexDataSize;
+    return *indexDataOffset + header.indexDataSize;
+}
+
+static bool IsTerminated(const char* string, u32 capacity)
+{
+    return memchr(string, '\0', capacity) != NULL;
+}
+
+//The records of a cache file are only trusted once every range they describe lies inside the
+//data blocks, submeshes being stored back to back in ascending order, and every string ends
+//inside its array
+bool ValidateMeshCacheRecords(const MeshCacheHeader& header, const MeshCacheSubmesh* submeshes, const MeshCacheMaterial* materials)
+{
+    u64 vertexEnd = 0;
+    u64 indexEnd = 0;
+    for (u32 i = 0; i < header.submeshCount; ++i)
+    {
+        const MeshCacheSubmesh& submesh = submeshes[i];
+        u64 indexDataEnd = submesh.indexOffset + (u64)submesh.indexCount * sizeof(u32);
+        if (submesh.vertexOffset < vertexEnd || submesh.vertexOffset > header.vertexDataSize ||
+            submesh.indexOffset < indexEnd || indexDataEnd > header.indexDataSize ||
+            submesh.stride == 0 || submesh.attributeCount > MESH_CACHE_MAX_ATTRIBUTES ||
+            submesh.materialIdx >= header.materialCount)
+        {
+            return false;
+        }
+        vertexEnd = submesh.vertexOffset;
+        indexEnd = indexDataEnd;
+    }
+
+    for (u32 i = 0; i < header.materialCount; ++i)
+    {
+        const MeshCacheMaterial& material = materials[i];
+        if (!IsTerminated(material.name, MESH_CACHE_NAME_LENGTH))
+            return false;
+        for (u32 slot = 0; slot < MeshCacheTexture_Count; ++slot)
+        {
+            if (!IsTerminated(material.textures[slot], MESH_CACHE_PATH_LENGTH))
+                return false;
+        }
+    }
+    return true;
+}
+
+u32 CreateModelFromCache(App* app, const char* filename, const MeshCacheHeader& header,
+    const MeshCacheSubmesh* submeshes, const MeshCacheMaterial* materials,
+    const u8* vertexData, const u8* indexData)
+{
+    app->meshes.push_back(Mesh());
+    Mesh& mesh = app->meshes.back();
+    u32 meshIdx = (u32)app->meshes.size() - 1u;
+
+    app->models.push_back(Model{});
+    Model& model = app->models.back();
+    model.meshIdx = meshIdx;
+    u32 modelIdx = (u32)app->models.size() - 1u;
+
+    //--Materials--
+    String directory = GetDirectoryPart(MakeString(filename));
+    std::vector<Material> modelMaterials(header.materialCount);
+    LoadCachedMaterials(app, materials, header.materialCount, directory, modelMaterials.data());
+
+    //Materials identical to already loaded ones are shared
+    std::vector<u32> materialIndices(header.materialCount);
+    for (u32 i = 0; i < header.materialCount; ++i)
+        materialIndices[i] = AddMaterial(app, modelMaterials[i]);
+
+    //--Submeshes--
+    for (u32 i = 0; i < header.submeshCount; ++i)
+    {
+        const MeshCacheSubmesh& cacheSubmesh = submeshes[i];
+
+        Submesh submesh = Submesh();
+        submesh.indexCount = cacheSubmesh.indexCount;
+        submesh.bounds.min = vec3(cacheSubmesh.boundsMin[0], cacheSubmesh.boundsMin[1], cacheSubmesh.boundsMin[2]);
+        submesh.bounds.max = vec3(cacheSubmesh.boundsMax[0], cacheSubmesh.boundsMax[1], cacheSubmesh.boundsMax[2]);
+        submesh.vertexBufferLayout.stride = (u8)cacheSubmesh.stride;
+        for (u32 j = 0; j < cacheSubmesh.attributeCount && j < MESH_CACHE_MAX_ATTRIBUTES; ++j)
+        {
+            const MeshCacheAttribute& attribute = cacheSubmesh.attributes[j];
+            submesh.vertexBufferLayout.attributes.push_back(VertexBufferAttribute(attribute.location, attribute.componentCount, attribute.offset));
+        }
+
+        //The submeshes are stored back to back, so each one ends where the next begins
+        u32 vertexEnd = i + 1 < header.submeshCount ? submeshes[i + 1].vertexOffset : header.vertexDataSize;
+        MeshArenaAllocation allocation = UploadToMeshArena(app, submesh.vertexBufferLayout,
+            vertexData + cacheSubmesh.vertexOffset, vertexEnd - cacheSubmesh.vertexOffset,
+            indexData + cacheSubmesh.indexOffset, cacheSubmesh.indexCount * sizeof(u32));
+        submesh.arenaIdx = allocation.arenaIdx;
+        submesh.baseVertex = allocation.baseVertex;
+        submesh.firstIndex = allocation.firstIndex;
+        mesh.submeshes.push_back(submesh);
+        ASSERT(cacheSubmesh.materialIdx < header.materialCount, "Submesh material out of range");
+        model.materialIdx.push_back(materialIndices[cacheSubmesh.materialIdx]);
+    }
+
+    return modelIdx;
+}
+
+u32 LoadModelFromCache(App* app, const char* filename, u64 sourceHash, u32 importFlags)
+{
+    if (sourceHash == 0)
+        return UINT32_MAX;
+
+    std::string cachePath = GetMeshCachePath(filename);
+    MappedFile file = MapFile(cachePath.c_str());
+    if (!file.data)
+        return UINT32_MAX;
+
+    //--Validate--
+    const MeshCacheHeader* header = (const MeshCacheHeader*)file.data;
+    if (file.size < sizeof(MeshCacheHeader) ||
+        header->magic != MESH_CACHE_MAGIC ||
+        header->version != MESH_CACHE_VERSION ||
+        header->sourceHash != sourceHash ||
+        header->importFlags != importFlags)
+    {
+        UnmapFile(file);
+        return UINT32_MAX;
+    }
+
+    u64 vertexDataOffset = 0;
+    u64 indexDataOffset = 0;
+    if (file.size < GetMeshCacheSize(*header, &vertexDataOffset, &indexDataOffset))
+    {
+        ELOG("Mesh cache %s is truncated, ignoring it", cachePath.c_str());
+        UnmapFile(file);
+        return UINT32_MAX;
+    }
+
+    const MeshCacheSubmesh* submeshes = (const MeshCacheSubmesh*)(file.data + sizeof(MeshCacheHeader));
+    const MeshCacheMaterial* materials = (const MeshCacheMaterial*)(submeshes + header->submeshCount);
+    if (!ValidateMeshCacheRecords(*header, submeshes, materials))
+    {
+        ELOG("Mesh cache %s is corrupt, ignoring it", cachePath.c_str());
+        UnmapFile(file);
+        return UINT32_MAX;
+    }
+
+    //--Upload straight from the mapping--
+    u32 modelIdx = CreateModelFromCache(app, filename, *header, submeshes, materials,
+        file.data + vertexDataOffset, file.data + indexDataOffset);
+
+    UnmapFile(file);
+    return modelIdx;
+}
+
+MeshCacheFile CreateMeshCacheFile(const char* filename, const MeshCacheHeader& header,
+    const MeshCacheSubmesh* submeshes, const MeshCacheMaterial* materials)
+{
+    MeshCacheFile cacheFile = {};
+    if (header.sourceHash == 0)
+        return cacheFile;
+
+    u64 vertexDataOffset = 0;
+    u64 indexDataOffset = 0;
+    u64 size = GetMeshCacheSize(header, &vertexDataOffset, &indexDataOffset);
+
+    cacheFile.path = GetMeshCachePath(filename);
+    cacheFile.file = CreateReplacementFile(cacheFile.path.c_str(), size);
+    if (!cacheFile.file.data)
+    {
+        ELOG("Could not create mesh cache %s", cacheFile.path.c_str());
+        return cacheFile;
+    }
+
+    //The mapping is writable, it is only const in MappedFile because MapFile ones are not.
+    //The header goes in last, on close, so a bake interrupted before that never validates
+    u8* data = (u8*)cacheFile.file.data;
+    cacheFile.header = header;
+    memset(data, 0, sizeof(MeshCacheHeader));
+    memcpy(data + sizeof(MeshCacheHeader), submeshes, header.submeshCount * sizeof(MeshCacheSubmesh));
+    memcpy(data + sizeof(MeshCacheHeader) + header.submeshCount * sizeof(MeshCacheSubmesh), materials, header.materialCount * sizeof(MeshCacheMaterial));
+    cacheFile.vertexData = data + vertexDataOffset;
+    cacheFile.indexData = data + indexDataOffset;
+
+    return cacheFile;
+}
+
+bool CloseMeshCacheFile(MeshCacheFile& cacheFile)
+{
+    bool committed = false;
+    if (cacheFile.file.data)
+    {
+        memcpy((u8*)cacheFile.file.data, &cacheFile.header, sizeof(MeshCacheHeader));
+        committed = CommitReplacementFile(cacheFile.file, cacheFile.path.c_str());
+        if (!committed)
+            ELOG("Could not replace mesh cache %s", cacheFile.path.c_str());
+    }
+    cacheFile = {};
+    return committed;
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+#include "platform.h"
+#include <glad/glad.h>
+
+//Binary cache of an imported model: the final interleaved vertex/index data of every
+//submesh, their vertex layouts and the material table. It is baked next to the source
+//file during an Assimp import and reused while the source hash (the model file and the
+//material libraries it references) and import flags match.
+//All values are stored in native endianness.
+
+#define MESH_CACHE_EXTENSION ".meshcache"
+#define MESH_CACHE_MAGIC 0x4353454Du //"MESC"
+#define MESH_CACHE_VERSION 2
+
+#define MESH_CACHE_MAX_ATTRIBUTES 8
+#define MESH_CACHE_NAME_LENGTH 64
+#define MESH_CACHE_PATH_LENGTH 128
+
+struct App;
+struct Mesh;
+struct Material;
+
+enum MeshCacheTextureSlot
+{
+    MeshCacheTexture_Albedo = 0,
+    MeshCacheTexture_Emissive,
+    MeshCacheTexture_Specular,
+    MeshCacheTexture_Normals,
+    MeshCacheTexture_Bump,
+    MeshCacheTexture_Count
+};
+
+struct MeshCacheHeader
+{
+    u32 magic;
+    u32 version;
+    u64 sourceHash;
+    u32 importFlags;
+    u32 submeshCount;
+    u32 materialCount;
+    u32 vertexDataSize;
+    u32 indexDataSize;
+    u32 padding;
+};
+
+struct MeshCacheAttribute
+{
+    u8 location;
+    u8 componentCount;
+    u8 offset;
+    u8 padding;
+};
+
+struct MeshCacheSubmesh
+{
+    u32 vertexOffset; //in bytes, inside the vertex data block
+    u32 indexOffset;  //in bytes, inside the index data block
+    u32 indexCount;
+    u32 materialIdx;  //relative to the first material of the model
+    u32 stride;
+    u32 attributeCount;
+    MeshCacheAttribute attributes[MESH_CACHE_MAX_ATTRIBUTES];
+    f32 boundsMin[3]; //model space AABB of the vertices
+    f32 boundsMax[3];
+};
+
+struct MeshCacheMaterial
+{
+    char name[MESH_CACHE_NAME_LENGTH];
+    f32 albedo[3];
+    f32 emissive[3];
+    f32 specular[3];
+    f32 smoothness;
+    char textures[MeshCacheTexture_Count][MESH_CACHE_PATH_LENGTH]; //relative to the model directory, empty if unused
+};
+
+/**
+ * Hashes the contents of a model source file so a cache can be matched against it. The
+ * material libraries of OBJ files are part of the hash, since the cached materials come
+ * from them. Returns 0 if the file cannot be read.
+ */
+u64 HashModelSource(const char* filename);
+
+/**
+ * Checks that every range the submesh records describe lies inside the data blocks of the
+ * header, that their layouts and material indices are in range and that the material names
+ * and texture paths are terminated inside their arrays.
+ */
+bool ValidateMeshCacheRecords(const MeshCacheHeader& header, const MeshCacheSubmesh* submeshes, const MeshCacheMaterial* materials);
+
+/**
+ * Fills count Materials from their cached descriptions. The textures they reference are
+ * loaded as a single batch so they are decoded in parallel.
+ */
+void LoadCachedMaterials(App* app, const MeshCacheMaterial* cacheMaterials, u32 count, String directory, Material* materials);
+
+/**
+ * Builds the mesh, model and materials described by the cache records, uploading each
+ * submesh from the vertex/index blocks to the mesh arena of its vertex format. Returns the
+ * model index.
+ */
+u32 CreateModelFromCache(App* app, const char* filename, const MeshCacheHeader& header,
+    const MeshCacheSubmesh* submeshes, const MeshCacheMaterial* materials,
+    const u8* vertexData, const u8* indexData);
+
+/**
+ * Loads a model from its cache file. The vertex and index blocks are uploaded to GL straight
+ * from the memory mapped file. Returns UINT32_MAX if there is no valid cache for the given
+ * source hash and import flags.
+ */
+u32 LoadModelFromCache(App* app, const char* filename, u64 sourceHash, u32 importFlags);
+
+/**
+ * Cache file mapped for writing. The records are already stored, the caller fills the vertex
+ * and index blocks in place and then calls CloseMeshCacheFile, which writes the header and
+ * renames the file over the previous cache. Returns false if it could not be put in place.
+ */
+struct MeshCacheFile
+{
+    MappedFile file;
+    MeshCacheHeader header;
+    std::string path;
+    u8* vertexData;
+    u8* indexData;
+};
+
+MeshCacheFile CreateMeshCacheFile(const char* filename, const MeshCacheHeader& header,
+    const MeshCacheSubmesh* submeshes, const MeshCacheMaterial* materials);
+bool CloseMeshCacheFile(MeshCacheFile& cacheFile);
@@ -6,264 +6,192 @@
 #else
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
 #include <unistd.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
 #endif
 
 #include "engine.h"
 #include "platform.h"
 
-#include <GLFW/glfw3.h>
 #include <stdio.h>
-#include <imgui.h>
-#include <imgui_impl_glfw.h>
-#include <imgui_impl_opengl3.h>
+#include <chrono>
 
-#define WINDOW_TITLE  "Advanced Graphics Programming"
-#define WINDOW_WIDTH  800
-#define WINDOW_HEIGHT 600
-
-#define GLOBAL_FRAME_ARENA_SIZE MB(16)
 u8* GlobalFrameArenaMemory = NULL;
 u32 GlobalFrameArenaHead = 0;
 
-void OnGlfwError(int errorCode, const char* errorMessage)
+#ifndef _WIN32
+//Releases whatever part of the headless EGL setup was created, shared by every exit of RunHeadless
+static void DestroyHeadlessContext(EGLDisplay display, EGLSurface surface, EGLContext context)
 {
-    fprintf(stderr, "glfw failed with error %d: %s\n", errorCode, errorMessage);
+    eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if (context != EGL_NO_CONTEXT)
+        eglDestroyContext(display, context);
+    if (surface != EGL_NO_SURFACE)
+        eglDestroySurface(display, surface);
+    eglTerminate(display);
 }
+#endif
 
-void OnGlfwMouseMoveEvent(GLFWwindow* window, double xpos, double ypos)
+int RunHeadless(App* app, u32 frameCount)
 {
-    App* app = (App*)glfwGetWindowUserPointer(window);
-    app->input.mouseDelta.x = (float)xpos - app->input.mousePos.x;
-    app->input.mouseDelta.y = (float)ypos - app->input.mousePos.y;
-    app->input.mousePos.x = (float)xpos;
-    app->input.mousePos.y = (float)ypos;
-
-    app->camera.ProcessMouseInput(app->input.mouseDelta);
+    HeadlessRun run;
+    run.frameCount = frameCount;
+    return RunHeadless(app, run);
 }
 
-void OnGlfwMouseEvent(GLFWwindow* window, int button, int event, int modifiers)
+int RunHeadless(App* app, const HeadlessRun& run)
 {
-    App* app = (App*)glfwGetWindowUserPointer(window);
-
-    switch (event) {
-        case GLFW_PRESS:
-            switch (button) {
-            case GLFW_MOUSE_BUTTON_RIGHT: app->input.mouseButtons[RIGHT] = BUTTON_PRESS; break;
-            case GLFW_MOUSE_BUTTON_LEFT:  app->input.mouseButtons[LEFT] = BUTTON_PRESS; break;
-            } break;
-        case GLFW_RELEASE:
-            switch (button) {
-            case GLFW_MOUSE_BUTTON_RIGHT: app->input.mouseButtons[RIGHT] = BUTTON_RELEASE; break;
-            case GLFW_MOUSE_BUTTON_LEFT:  app->input.mouseButtons[LEFT] = BUTTON_RELEASE; break;
-            } break;
+    const u32 frameCount = run.frameCount;
+#ifdef _WIN32
+    ELOG("Headless mode needs an EGL driver and is only available on Linux builds\n");
+    return -1;
+#else
+    //--Display: prefer the surfaceless platform so no X/Wayland server is needed--
+    EGLDisplay display = EGL_NO_DISPLAY;
+    EGLint eglMajor = 0, eglMinor = 0;
+#ifdef EGL_PLATFORM_SURFACELESS_MESA
+    PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+    if (getPlatformDisplay)
+    {
+        display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+        if (display != EGL_NO_DISPLAY && !eglInitialize(display, &eglMajor, &eglMinor))
+            display = EGL_NO_DISPLAY;
     }
-}
-
-void OnGlfwScrollEvent(GLFWwindow* window, double xoffset, double yoffset)
-{
-    //Nothing yet...
-}
-
-void OnGlfwKeyboardEvent(GLFWwindow* window, int key, int scancode, int action, int mods)
-{
-    //--Remap key to our enum values--
-    switch (key) {
-        case GLFW_KEY_SPACE:  key = K_SPACE; break;
-        case GLFW_KEY_0: key = K_0; break; case GLFW_KEY_1: key = K_1; break; case GLFW_KEY_2: key = K_2; break;
-        case GLFW_KEY_3: key = K_3; break; case GLFW_KEY_4: key = K_4; break; case GLFW_KEY_5: key = K_5; break;
-        case GLFW_KEY_6: key = K_6; break; case GLFW_KEY_7: key = K_7; break; case GLFW_KEY_8: key = K_8; break;
-        case GLFW_KEY_9: key = K_9; break;
-        case GLFW_KEY_A: key = K_A; break; case GLFW_KEY_B: key = K_B; break; case GLFW_KEY_C: key = K_C; break;
-        case GLFW_KEY_D: key = K_D; break; case GLFW_KEY_E: key = K_E; break; case GLFW_KEY_F: key = K_F; break;
-        case GLFW_KEY_G: key = K_G; break; case GLFW_KEY_H: key = K_H; break; case GLFW_KEY_I: key = K_I; break;
-        case GLFW_KEY_J: key = K_J; break; case GLFW_KEY_K: key = K_K; break; case GLFW_KEY_L: key = K_L; break;
-        case GLFW_KEY_M: key = K_M; break; case GLFW_KEY_N: key = K_N; break; case GLFW_KEY_O: key = K_O; break;
-        case GLFW_KEY_P: key = K_P; break; case GLFW_KEY_Q: key = K_Q; break; case GLFW_KEY_R: key = K_R; break;
-        case GLFW_KEY_S: key = K_S; break; case GLFW_KEY_T: key = K_T; break; case GLFW_KEY_U: key = K_U; break;
-        case GLFW_KEY_V: key = K_V; break; case GLFW_KEY_W: key = K_W; break; case GLFW_KEY_X: key = K_X; break;
-        case GLFW_KEY_Y: key = K_Y; break; case GLFW_KEY_Z: key = K_Z; break;
-        case GLFW_KEY_ESCAPE: key = K_ESCAPE; break;
-        case GLFW_KEY_LEFT_SHIFT: key = K_SHIFT; break;
-        case GLFW_KEY_ENTER:  key = K_ENTER; break;
+#endif
+    if (display == EGL_NO_DISPLAY)
+    {
+        display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+        if (display == EGL_NO_DISPLAY || !eglInitialize(display, &eglMajor, &eglMinor))
+        {
+            ELOG("eglInitialize() failed with error 0x%x\n", eglGetError());
+            return -1;
+        }
     }
 
-    App* app = (App*)glfwGetWindowUserPointer(window);
-    switch (action) {
-        case GLFW_PRESS:   app->input.keys[key] = BUTTON_PRESS; break;
-        case GLFW_RELEASE: app->input.keys[key] = BUTTON_RELEASE; break;
+    //--Offscreen pbuffer surface with the same size as the window would have--
+    const EGLint configAttributes[] = {
+        EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_RED_SIZE, 8,
+        EGL_GREEN_SIZE, 8,
+        EGL_BLUE_SIZE, 8,
+        EGL_ALPHA_SIZE, 8,
+        EGL_DEPTH_SIZE, 24,
+        EGL_NONE
+    };
+    EGLConfig config;
+    EGLint configCount = 0;
+    if (!eglChooseConfig(display, configAttributes, &config, 1, &configCount) || configCount == 0)
+    {
+        ELOG("eglChooseConfig() found no pbuffer config\n");
+        DestroyHeadlessContext(display, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        return -1;
     }
-}
-
-void OnGlfwCharEvent(GLFWwindow* window, unsigned int character)
-{
-    //Nothing yet...
-}
-
-void OnGlfwResizeFramebuffer(GLFWwindow* window, int width, int height)
-{
-    App* app = (App*)glfwGetWindowUserPointer(window);
-    app->displaySize = vec2(width, height);
-}
-
-void OnGlfwCloseWindow(GLFWwindow* window)
-{
-    App* app = (App*)glfwGetWindowUserPointer(window);
-    app->isRunning = false;
-}
-
-int main()
-{
-    App app = {};
-    app.deltaTime = 1.0f / 60.0f;
-    app.displaySize = ivec2(WINDOW_WIDTH, WINDOW_HEIGHT);
-    app.isRunning = true;
-
-    glfwSetErrorCallback(OnGlfwError);
 
-    if (!glfwInit())
+    const EGLint surfaceAttributes[] = {
+        EGL_WIDTH, app->displaySize.x,
+        EGL_HEIGHT, app->displaySize.y,
+        EGL_NONE
+    };
+    EGLSurface surface = eglCreatePbufferSurface(display, config, surfaceAttributes);
+    if (surface == EGL_NO_SURFACE)
     {
-        ELOG("glfwInit() failed\n");
+        ELOG("eglCreatePbufferSurface() failed with error 0x%x\n", eglGetError());
+        DestroyHeadlessContext(display, EGL_NO_SURFACE, EGL_NO_CONTEXT);
         return -1;
     }
 
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-    glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, true);
-
-    GLFWwindow* window = glfwCreateWindow(WINDOW_WIDTH, WINDOW_HEIGHT, WINDOW_TITLE, NULL, NULL);
-    if (!window)
+    //--Same 4.3 core context the window path asks glfw for--
+    eglBindAPI(EGL_OPENGL_API);
+    const EGLint contextAttributes[] = {
+        EGL_CONTEXT_MAJOR_VERSION, 4,
+        EGL_CONTEXT_MINOR_VERSION, 3,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE
+    };
+    EGLContext context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttributes);
+    if (context == EGL_NO_CONTEXT || !eglMakeCurrent(display, surface, surface, context))
     {
-        ELOG("glfwCreateWindow() failed\n");
+        ELOG("eglCreateContext() failed with error 0x%x\n", eglGetError());
+        DestroyHeadlessContext(display, surface, context);
         return -1;
     }
 
-    glfwSetWindowUserPointer(window, &app);
-
-    glfwSetMouseButtonCallback(window, OnGlfwMouseEvent);
-    glfwSetCursorPosCallback(window, OnGlfwMouseMoveEvent);
-    glfwSetScrollCallback(window, OnGlfwScrollEvent);
-    glfwSetKeyCallback(window, OnGlfwKeyboardEvent);
-    glfwSetCharCallback(window, OnGlfwCharEvent);
-    glfwSetFramebufferSizeCallback(window, OnGlfwResizeFramebuffer);
-    glfwSetWindowCloseCallback(window, OnGlfwCloseWindow);
-
-    glfwMakeContextCurrent(window);
-
-    //--Load all OpenGL functions using the glfw loader function--
-    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+    if (!gladLoadGLLoader((GLADloadproc)eglGetProcAddress))
     {
         ELOG("Failed to initialize OpenGL context\n");
+        DestroyHeadlessContext(display, surface, context);
         return -1;
     }
 
-    IMGUI_CHECKVERSION();
-    ImGui::CreateContext();
-
-    ImGuiIO& io = ImGui::GetIO(); (void)io;
-    io.ConfigFlags |= ImGuiConfigFlags_NavEnableKeyboard;       // Enable Keyboard Controls
-    io.ConfigFlags |= ImGuiConfigFlags_DockingEnable;           // Enable Docking
-    io.ConfigFlags |= ImGuiConfigFlags_ViewportsEnable;         // Enable Multi-Viewport / Platform Windows
-    io.ConfigFlags |= ImGuiConfigFlags_NavEnableSetMousePos;
-
-    //--Setup Dear ImGui style--
-    ImGui::StyleColorsDark();
-
-    //When viewports are enabled we tweak WindowRounding/WindowBg so platform windows can look identical to regular ones
-    ImGuiStyle& style = ImGui::GetStyle();
-    if (io.ConfigFlags & ImGuiConfigFlags_ViewportsEnable)
-    {
-        style.WindowRounding = 0.0f;
-        style.Colors[ImGuiCol_WindowBg].w = 1.0f;
-    }
+    GlobalFrameArenaMemory = (u8*)malloc(GLOBAL_FRAME_ARENA_SIZE);
 
-    if (!ImGui_ImplGlfw_InitForOpenGL(window, true))
-    {
-        ELOG("ImGui_ImplGlfw_InitForOpenGL() failed\n");
-        return -1;
-    }
+    //There is no mouse to pull the camera out of its straight-up default pitch, so start level
+    app->camera.pitch = 0.0f;
 
-    if (!ImGui_ImplOpenGL3_Init("#version 430"))
-    {
-        ELOG("Failed to initialize ImGui OpenGL wrapper\n");
-        return -1;
-    }
+    typedef std::chrono::steady_clock Clock;
+    Clock::time_point initStartTime = Clock::now();
+    Init(app);
+    f64 initSeconds = std::chrono::duration<f64>(Clock::now() - initStartTime).count();
 
-    f64 lastFrameTime = glfwGetTime();
+    //Init stops the app when it cannot set it up (an invalid scene...): no frame is rendered
+    //and the run has to fail, not pass as an empty one
+    const bool initFailed = !app->isRunning;
+    if (initFailed)
+        ELOG("Headless: Init failed, no frame will be rendered");
 
-    GlobalFrameArenaMemory = (u8*)malloc(GLOBAL_FRAME_ARENA_SIZE);
+    ILOG("Headless: Init (asset loading included) took %.3f s", initSeconds);
+    ILOG("Headless: EGL %d.%d, %s, rendering %u frames at %dx%d", eglMajor, eglMinor,
+        app->info.renderer.c_str(), frameCount, app->displaySize.x, app->displaySize.y);
 
-    Init(&app);
+    //--Frame loop: no window, no input and no ImGui--
+    Clock::time_point startTime = Clock::now();
+    Clock::time_point lastFrameTime = startTime;
+    u32 frame = 0;
 
-    while (app.isRunning)
+    for (; frame < frameCount && app->isRunning; ++frame)
     {
-        //Tell GLFW to call platform callbacks
-        glfwPollEvents();
-
-        //--ImGui--
-        ImGui_ImplOpenGL3_NewFrame();
-        ImGui_ImplGlfw_NewFrame();
-        ImGui::NewFrame();
-        Gui(&app);
-        ImGui::Render();
-
-        //Clear input state if required by ImGui
-        if (ImGui::GetIO().WantCaptureKeyboard)
-            for (u32 i = 0; i < KEY_COUNT; ++i)
-                app.input.keys[i] = BUTTON_IDLE;
-
-        if (ImGui::GetIO().WantCaptureMouse)
-            for (u32 i = 0; i < MOUSE_BUTTON_COUNT; ++i)
-                app.input.mouseButtons[i] = BUTTON_IDLE;
-
-        Update(&app);
-
-        //--Transition input key/button states--
-        if (!ImGui::GetIO().WantCaptureKeyboard)
-            for (u32 i = 0; i < KEY_COUNT; ++i)
-                if (app.input.keys[i] == BUTTON_PRESS)   app.input.keys[i] = BUTTON_PRESSED;
-                else if (app.input.keys[i] == BUTTON_RELEASE) app.input.keys[i] = BUTTON_IDLE;
-
-        if (!ImGui::GetIO().WantCaptureMouse)
-            for (u32 i = 0; i < MOUSE_BUTTON_COUNT; ++i)
-                if (app.input.mouseButtons[i] == BUTTON_PRESS)   app.input.mouseButtons[i] = BUTTON_PRESSED;
-                else if (app.input.mouseButtons[i] == BUTTON_RELEASE) app.input.mouseButtons[i] = BUTTON_IDLE;
-
-        app.input.mouseDelta = glm::vec2(0.0f, 0.0f);
-
-        Render(&app);
-
-        //--ImGui Render--
-        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
-        if (io.ConfigFlags & ImGuiConfigFlags_ViewportsEnable) {
-            GLFWwindow* backup_current_context = glfwGetCurrentContext();
-            ImGui::UpdatePlatformWindows();
-            ImGui::RenderPlatformWindowsDefault();
-            glfwMakeContextCurrent(backup_current_context);
+        PROFILE_SCOPE("Frame");
+
+        if (run.beforeFrame)
+            run.beforeFrame(app, frame, run.user);
+
+        Clock::time_point frameStartTime = Clock::now();
+        Update(app);
+        Render(app);
+        Clock::time_point submitTime = Clock::now();
+
+        //Wait for the GPU so the frame time measures the whole frame, not just command submission
+        glFinish();
+
+        Clock::time_point currentFrameTime = Clock::now();
+        f32 frameSeconds = std::chrono::duration<f32>(currentFrameTime - lastFrameTime).count();
+        app->deltaTime = run.fixedDeltaTime > 0.0f ? run.fixedDeltaTime : frameSeconds;
+        if (run.afterFrame)
+        {
+            f64 cpuMilliseconds = std::chrono::duration<f64, std::milli>(submitTime - frameStartTime).count();
+            run.afterFrame(app, frame, cpuMilliseconds, frameSeconds * 1000.0, run.user);
         }
-
-        //--Present image on screen--
-        glfwSwapBuffers(window);
-
-        //--Frame time--
-        f64 currentFrameTime = glfwGetTime();
-        app.deltaTime = (f32)(currentFrameTime - lastFrameTime);
         lastFrameTime = currentFrameTime;
 
         //Reset frame allocator
         GlobalFrameArenaHead = 0;
     }
 
-    free(GlobalFrameArenaMemory);
+    f64 totalSeconds = std::chrono::duration<f64>(Clock::now() - startTime).count();
+    if (frame > 0)
+        ILOG("Headless: %u frames in %.3f s (%.3f ms/frame, %.1f FPS)", frame, totalSeconds,
+            1000.0 * totalSeconds / frame, frame / totalSeconds);
 
-    ImGui_ImplOpenGL3_Shutdown();
-    ImGui_ImplGlfw_Shutdown();
+    Shutdown(app);
+    free(GlobalFrameArenaMemory);
 
-    glfwDestroyWindow(window);
-    glfwTerminate();
-    return 0;
+    DestroyHeadlessContext(display, surface, context);
+    return initFailed ? -1 : 0;
+#endif
 }
 
 u32 Strlen(const char* string)
@@ -392,6 +320,175 @@ u64 GetFileLastWriteTimestamp(const char* filepath)
     return 0;
 }
 
+MappedFile MapFile(const char* filepath)
+{
+    MappedFile file = {};
+
+#ifdef _WIN32
+    HANDLE fileHandle = CreateFileA(filepath, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (fileHandle == INVALID_HANDLE_VALUE)
+        return file;
+
+    LARGE_INTEGER fileSize;
+    if (GetFileSizeEx(fileHandle, &fileSize) && fileSize.QuadPart > 0)
+    {
+        HANDLE mappingHandle = CreateFileMappingA(fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (mappingHandle)
+        {
+            file.data = (const u8*)MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+            if (file.data)
+            {
+                file.size = (u64)fileSize.QuadPart;
+                file.handle = mappingHandle;
+            }
+            else
+            {
+                CloseHandle(mappingHandle);
+            }
+        }
+    }
+    CloseHandle(fileHandle);
+#else
+    int fd = open(filepath, O_RDONLY);
+    if (fd < 0)
+        return file;
+
+    struct stat attrib;
+    if (fstat(fd, &attrib) == 0 && attrib.st_size > 0)
+    {
+        void* data = mmap(NULL, attrib.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data != MAP_FAILED)
+        {
+            file.data = (const u8*)data;
+            file.size = (u64)attrib.st_size;
+        }
+    }
+    close(fd);
+#endif
+
+    return file;
+}
+
+MappedFile CreateMappedFile(const char* filepath, u64 size)
+{
+    MappedFile file = {};
+    if (size == 0)
+        return file;
+
+#ifdef _WIN32
+    HANDLE fileHandle = CreateFileA(filepath, GENERIC_READ | GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (fileHandle == INVALID_HANDLE_VALUE)
+        return file;
+
+    HANDLE mappingHandle = CreateFileMappingA(fileHandle, NULL, PAGE_READWRITE, (DWORD)(size >> 32), (DWORD)size, NULL);
+    if (mappingHandle)
+    {
+        file.data = (const u8*)MapViewOfFile(mappingHandle, FILE_MAP_WRITE, 0, 0, 0);
+        if (file.data)
+        {
+            file.size = size;
+            file.handle = mappingHandle;
+        }
+        else
+        {
+            CloseHandle(mappingHandle);
+        }
+    }
+    CloseHandle(fileHandle);
+#else
+    int fd = open(filepath, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+        return file;
+
+    if (ftruncate(fd, (off_t)size) == 0)
+    {
+        void* data = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (data != MAP_FAILED)
+        {
+            file.data = (const u8*)data;
+            file.size = size;
+        }
+    }
+    close(fd);
+#endif
+
+    return file;
+}
+
+//Written next to the final path, so the rename never crosses file systems
+static std::string GetReplacementFilePath(const char* filepath)
+{
+#ifdef _WIN32
+    const u32 processId = (u32)GetCurrentProcessId();
+#else
+    const u32 processId = (u32)getpid();
+#endif
+    char suffix[32];
+    snprintf(suffix, sizeof(suffix), ".tmp.%u", processId);
+    return std::string(filepath) + suffix;
+}
+
+MappedFile CreateReplacementFile(const char* filepath, u64 size)
+{
+    std::string tempPath = GetReplacementFilePath(filepath);
+    MappedFile file = CreateMappedFile(tempPath.c_str(), size);
+    if (!file.data)
+        remove(tempPath.c_str());
+    return file;
+}
+
+bool CommitReplacementFile(MappedFile& file, const char* filepath)
+{
+    if (!file.data)
+        return false;
+    UnmapFile(file);
+
+    std::string tempPath = GetReplacementFilePath(filepath);
+#ifdef _WIN32
+    bool renamed = MoveFileExA(tempPath.c_str(), filepath, MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    bool renamed = rename(tempPath.c_str(), filepath) == 0;
+#endif
+    if (!renamed)
+        remove(tempPath.c_str());
+    return renamed;
+}
+
+void DiscardReplacementFile(MappedFile& file, const char* filepath)
+{
+    if (!file.data)
+        return;
+    UnmapFile(file);
+    remove(GetReplacementFilePath(filepath).c_str());
+}
+
+void UnmapFile(MappedFile& file)
+{
+    if (!file.data)
+        return;
+
+#ifdef _WIN32
+    UnmapViewOfFile(file.data);
+    CloseHandle((HANDLE)file.handle);
+#else
+    munmap((void*)file.data, file.size);
+#endif
+
+    file = {};
+}
+
+u64 HashBytes(const void* bytes, u64 byteCount, u64 seed)
+{
+    const u8* ptr = (const u8*)bytes;
+    u64 hash = seed;
+    while (byteCount--)
+    {
+        hash ^= *ptr++;
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
 void LogString(const char* str)
 {
 #ifdef _WIN32
@@ -53,6 +53,8 @@ struct Input {
     ButtonState keys[KEY_COUNT];
 };
 
+struct App;
+
 struct String
 {
     char* str;
@@ -68,7 +70,36 @@ void OnGlfwCharEvent(GLFWwindow* window, unsigned int character);
 void OnGlfwResizeFramebuffer(GLFWwindow* window, int width, int height);
 void OnGlfwCloseWindow(GLFWwindow* window);
 
-int main();
+int main(int argc, char** argv);
+
+#define WINDOW_WIDTH  800
+#define WINDOW_HEIGHT 600
+
+#define GLOBAL_FRAME_ARENA_SIZE MB(16)
+extern u8* GlobalFrameArenaMemory;
+extern u32 GlobalFrameArenaHead;
+
+//Frame loop settings and hooks of RunHeadless, for benchmarks that drive the app
+struct HeadlessRun
+{
+    u32 frameCount = 0;
+    f32 fixedDeltaTime = 0.0f; //The measured frame time is used when 0
+    void* user = NULL;
+
+    //Before Update, and once the GPU has finished the frame with the CPU time of
+    //Update + Render and the time of the whole frame
+    void (*beforeFrame)(App* app, u32 frame, void* user) = NULL;
+    void (*afterFrame)(App* app, u32 frame, f64 cpuMilliseconds, f64 frameMilliseconds, void* user) = NULL;
+};
+
+/**
+ * Runs Init/Update/Render for a fixed number of frames on an offscreen EGL pbuffer,
+ * without creating a window or ImGui. Meant for benchmark runs on machines without
+ * a display (e.g. Mesa llvmpipe on CI nodes). Enabled with --headless [--frames N].
+ * Returns 0 once the frames are rendered, -1 if the context cannot be created or Init fails.
+ */
+int RunHeadless(App* app, u32 frameCount);
+int RunHeadless(App* app, const HeadlessRun& run);
 
 u32 Strlen(const char* string);
 void* PushSize(u32 byteCount);
@@ -91,17 +122,61 @@ String ReadTextFile(const char *filepath);
  */
 u64 GetFileLastWriteTimestamp(const char *filepath);
 
+/**
+ * Read-only memory mapping of a whole file. data is NULL if the file could not be
+ * opened or is empty. The mapping stays valid until UnmapFile is called.
+ */
+struct MappedFile
+{
+    const u8* data;
+    u64       size;
+    void*     handle;
+};
+
+MappedFile MapFile(const char* filepath);
+
+/**
+ * Creates (or truncates) a file of the given size and maps it for writing.
+ * The contents are flushed to disk when the mapping is released with UnmapFile.
+ */
+MappedFile CreateMappedFile(const char* filepath, u64 size);
+
+/**
+ * Same as CreateMappedFile, but the file is written under a temporary name unique to this
+ * process, next to filepath. CommitReplacementFile unmaps it and renames it over filepath in
+ * one atomic step, so other processes that have the previous file mapped keep reading it
+ * intact instead of seeing it truncated under them.
+ */
+MappedFile CreateReplacementFile(const char* filepath, u64 size);
+
+/**
+ * Returns false, removing the temporary file, if it could not be renamed into place.
+ */
+bool CommitReplacementFile(MappedFile& file, const char* filepath);
+
+/**
+ * Unmaps and removes the temporary file, leaving filepath untouched.
+ */
+void DiscardReplacementFile(MappedFile& file, const char* filepath);
+
+void UnmapFile(MappedFile& file);
+
+/**
+ * 64-bit FNV-1a hash. Pass a previous result as seed to hash several blocks as one.
+ */
+u64 HashBytes(const void* bytes, u64 byteCount, u64 seed = 14695981039346656037ull);
+
 /**
  * It logs a string to whichever outputs are configured in the platform layer.
  * By default, the string is printed in the output console of VisualStudio.
  */
 void LogString(const char* str);
 
-#define ILOG(...)                 \
-{                                 \
-char logBuffer[1024] = {};        \
-sprintf(logBuffer, __VA_ARGS__);  \
-LogString(logBuffer);             \
+#define ILOG(...)                                    \
+{                                                    \
+char logBuffer[2048] = {};                           \
+snprintf(logBuffer, sizeof(logBuffer), __VA_ARGS__); \
+LogString(logBuffer);                                \
 }
 
 #define ELOG(...) ILOG(__VA_ARGS__)
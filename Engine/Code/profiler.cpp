@@ -0,0 +1,160 @@
+#include "profiler.h"
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <stdio.h>
+#include <string.h>
+
+typedef std::chrono::steady_clock Clock;
+
+struct ProfilerThread
+{
+    std::unique_ptr<ProfilerEvent[]> events;
+    std::atomic<u64> eventCount{0};
+    u32 threadId = 0;
+    char name[64] = {};
+};
+
+//Rings are never freed: the ones of exited threads go back to the free list and are handed
+//to the next new thread, so short lived threads do not pile up buffers. Until then their
+//events are still saved with the rest.
+struct ProfilerThreads
+{
+    std::mutex mutex;
+    std::vector<ProfilerThread*> threads;
+    std::vector<ProfilerThread*> freeThreads;
+};
+
+static ProfilerThreads& GetProfilerThreads()
+{
+    static ProfilerThreads threads;
+    return threads;
+}
+
+static const Clock::time_point s_profilerEpoch = Clock::now();
+
+struct ProfilerThreadSlot
+{
+    ProfilerThread* thread = nullptr;
+
+    ~ProfilerThreadSlot()
+    {
+        if (!thread)
+            return;
+        ProfilerThreads& threads = GetProfilerThreads();
+        std::lock_guard<std::mutex> lock(threads.mutex);
+        threads.freeThreads.push_back(thread);
+    }
+};
+
+static thread_local ProfilerThreadSlot t_profilerSlot;
+
+static ProfilerThread* GetProfilerThread()
+{
+    if (t_profilerSlot.thread)
+        return t_profilerSlot.thread;
+
+    ProfilerThreads& threads = GetProfilerThreads();
+    std::lock_guard<std::mutex> lock(threads.mutex);
+    ProfilerThread* thread;
+    if (!threads.freeThreads.empty())
+    {
+        //The events of the thread that exited are dropped
+        thread = threads.freeThreads.back();
+        threads.freeThreads.pop_back();
+        thread->eventCount.store(0, std::memory_order_release);
+    }
+    else
+    {
+        thread = new ProfilerThread();
+        thread->events.reset(new ProfilerEvent[PROFILER_EVENTS_PER_THREAD]);
+        thread->threadId = (u32)threads.threads.size() + 1;
+        threads.threads.push_back(thread);
+    }
+    snprintf(thread->name, sizeof(thread->name), "Thread %u", thread->threadId);
+    t_profilerSlot.thread = thread;
+    return thread;
+}
+
+u64 GetProfilerTime()
+{
+    return (u64)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - s_profilerEpoch).count();
+}
+
+ProfileScope::ProfileScope(const char* scopeName)
+    : name(scopeName), start(GetProfilerTime())
+{}
+
+ProfileScope::~ProfileScope()
+{
+    u64 end = GetProfilerTime();
+    ProfilerThread* thread = GetProfilerThread();
+
+    //Only this thread writes the ring, the count tells the readers what is complete
+    u64 eventIdx = thread->eventCount.load(std::memory_order_relaxed);
+    ProfilerEvent& event = thread->events[eventIdx % PROFILER_EVENTS_PER_THREAD];
+    event.name = name;
+    event.start = start;
+    event.end = end;
+    thread->eventCount.store(eventIdx + 1, std::memory_order_release);
+}
+
+void SetProfilerThreadName(const char* name)
+{
+    ProfilerThread* thread = GetProfilerThread();
+    std::lock_guard<std::mutex> lock(GetProfilerThreads().mutex);
+    snprintf(thread->name, sizeof(thread->name), "%s", name);
+}
+
+static void WriteJsonString(FILE* file, const char* string)
+{
+    fputc('"', file);
+    for (; *string; ++string)
+    {
+        if (*string == '"' || *string == '\\')
+            fputc('\\', file);
+        if ((u8)*string >= 0x20)
+            fputc(*string, file);
+    }
+    fputc('"', file);
+}
+
+bool SaveChromeTrace(const char* filepath)
+{
+    FILE* file = fopen(filepath, "wb");
+    if (!file)
+        return false;
+
+    ProfilerThreads& threads = GetProfilerThreads();
+    std::lock_guard<std::mutex> lock(threads.mutex);
+
+    //Timestamps are in microseconds
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    bool first = true;
+    for (ProfilerThread* thread : threads.threads)
+    {
+        fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":", first ? "" : ",\n", thread->threadId);
+        WriteJsonString(file, thread->name);
+        fprintf(file, "}}");
+        first = false;
+
+        //Once a ring has wrapped the thread may be overwriting its oldest events while they
+        //are read, so only the newest half is written
+        u64 eventCount = thread->eventCount.load(std::memory_order_acquire);
+        u64 firstEvent = eventCount > PROFILER_EVENTS_PER_THREAD ? eventCount - PROFILER_EVENTS_PER_THREAD / 2 : 0;
+        for (u64 i = firstEvent; i < eventCount; ++i)
+        {
+            const ProfilerEvent& event = thread->events[i % PROFILER_EVENTS_PER_THREAD];
+            fprintf(file, ",\n{\"name\":");
+            WriteJsonString(file, event.name);
+            fprintf(file, ",\"cat\":\"cpu\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%u}",
+                event.start / 1000.0, (event.end - event.start) / 1000.0, thread->threadId);
+        }
+    }
+    fprintf(file, "\n]}\n");
+
+    bool success = ferror(file) == 0;
+    fclose(file);
+    return success;
+}
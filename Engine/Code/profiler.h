@@ -0,0 +1,55 @@
+#pragma once
+
+#include "platform.h"
+
+//CPU instrumentation. PROFILE_SCOPE("Name") records when the enclosing scope starts and
+//ends on the calling thread, and SaveChromeTrace writes everything recorded so far as a
+//Chrome trace, to be opened in chrome://tracing or ui.perfetto.dev.
+//Every thread records to its own ring of events, created the first time it records one,
+//so recording never takes a lock: the thread writes the event and then publishes it by
+//bumping an atomic count. Each ring keeps the last PROFILER_EVENTS_PER_THREAD events.
+//Names must outlive the trace, string literals in practice.
+//Define ENGINE_DISABLE_PROFILER to compile the scopes out.
+
+#define PROFILER_EVENTS_PER_THREAD 65536
+
+struct ProfilerEvent
+{
+    const char* name;
+    u64 start; //Nanoseconds since the profiler started
+    u64 end;
+};
+
+struct ProfileScope
+{
+    const char* name;
+    u64 start;
+
+    ProfileScope(const char* scopeName);
+    ~ProfileScope();
+};
+
+#ifdef ENGINE_DISABLE_PROFILER
+#define PROFILE_SCOPE(name)
+#else
+#define PROFILE_SCOPE_JOIN(a, b) a##b
+#define PROFILE_SCOPE_NAME(line) PROFILE_SCOPE_JOIN(profileScope, line)
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_SCOPE_NAME(__LINE__)(name)
+#endif
+
+/**
+ * Nanoseconds since the profiler started, from a monotonic clock.
+ */
+u64 GetProfilerTime();
+
+/**
+ * Names the calling thread in the traces. Threads are "Thread N" otherwise.
+ */
+void SetProfilerThreadName(const char* name);
+
+/**
+ * Writes the events of every thread to filepath as Chrome trace JSON. Threads may keep
+ * recording meanwhile; only the events published before the call are written. Returns
+ * false if the file could not be written.
+ */
+bool SaveChromeTrace(const char* filepath);
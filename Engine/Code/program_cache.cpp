@@ -0,0 +1,115 @@
+#include "program_cache.h"
+#include "engine.h"
+#include <string.h>
+
+static std::string GetProgramCachePath(const char* filepath, const char* programName)
+{
+    return std::string(filepath) + "." + programName + PROGRAM_CACHE_EXTENSION;
+}
+
+u64 ComputeProgramCacheKey(String source, const char* preamble)
+{
+    GLint formatCount = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+    if (formatCount <= 0)
+        return 0;
+
+    std::vector<GLint> formats(formatCount);
+    glGetIntegerv(GL_PROGRAM_BINARY_FORMATS, formats.data());
+
+    u64 hash = HashBytes(source.str, source.len);
+    hash = HashBytes(preamble, strlen(preamble), hash);
+    hash = HashBytes(formats.data(), formats.size() * sizeof(GLint), hash);
+
+    //Binaries only load on the driver that produced them
+    const GLenum driverStrings[] = { GL_VENDOR, GL_RENDERER, GL_VERSION };
+    for (GLenum name : driverStrings)
+    {
+        const char* value = (const char*)glGetString(name);
+        if (value)
+            hash = HashBytes(value, strlen(value), hash);
+    }
+    return hash != 0 ? hash : 1;
+}
+
+GLuint LoadProgramFromCache(const char* filepath, const char* programName, u64 key)
+{
+    if (key == 0)
+        return 0;
+
+    std::string cachePath = GetProgramCachePath(filepath, programName);
+    MappedFile file = MapFile(cachePath.c_str());
+    if (!file.data)
+        return 0;
+
+    //--Validate--
+    const ProgramCacheHeader* header = (const ProgramCacheHeader*)file.data;
+    if (file.size < sizeof(ProgramCacheHeader) ||
+        header->magic != PROGRAM_CACHE_MAGIC ||
+        header->version != PROGRAM_CACHE_VERSION ||
+        header->key != key ||
+        file.size < sizeof(ProgramCacheHeader) + header->binarySize)
+    {
+        UnmapFile(file);
+        return 0;
+    }
+
+    GLuint programHandle = glCreateProgram();
+    glProgramBinary(programHandle, header->binaryFormat, file.data + sizeof(ProgramCacheHeader), header->binarySize);
+    UnmapFile(file);
+
+    //Drivers may reject their own binaries, e.g. after an update that kept the version string
+    GLint success = GL_FALSE;
+    glGetProgramiv(programHandle, GL_LINK_STATUS, &success);
+    if (!success)
+    {
+        glDeleteProgram(programHandle);
+        return 0;
+    }
+    return programHandle;
+}
+
+void SaveProgramToCache(const char* filepath, const char* programName, u64 key, GLuint programHandle)
+{
+    if (key == 0)
+        return;
+
+    GLint success = GL_FALSE;
+    glGetProgramiv(programHandle, GL_LINK_STATUS, &success);
+    GLint binarySize = 0;
+    glGetProgramiv(programHandle, GL_PROGRAM_BINARY_LENGTH, &binarySize);
+    if (!success || binarySize <= 0)
+        return;
+
+    std::string cachePath = GetProgramCachePath(filepath, programName);
+    //Written aside and renamed over the old cache, which another process may be loading
+    MappedFile file = CreateReplacementFile(cachePath.c_str(), sizeof(ProgramCacheHeader) + binarySize);
+    if (!file.data)
+    {
+        ELOG("Could not create program cache %s", cachePath.c_str());
+        return;
+    }
+
+    //The binary goes straight into the mapping, the header last so an interrupted write
+    //never validates
+    u8* data = (u8*)file.data;
+    GLsizei length = 0;
+    GLenum binaryFormat = 0;
+    glGetProgramBinary(programHandle, binarySize, &length, &binaryFormat, data + sizeof(ProgramCacheHeader));
+    if (length <= 0)
+    {
+        DiscardReplacementFile(file, cachePath.c_str());
+        return;
+    }
+
+    ProgramCacheHeader header = {};
+    header.magic = PROGRAM_CACHE_MAGIC;
+    header.version = PROGRAM_CACHE_VERSION;
+    header.key = key;
+    header.binaryFormat = binaryFormat;
+    header.binarySize = (u32)length;
+    memcpy(data, &header, sizeof(ProgramCacheHeader));
+
+    if (!CommitReplacementFile(file, cachePath.c_str()))
+        ELOG("Could not replace program cache %s", cachePath.c_str());
+}
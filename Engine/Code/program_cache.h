@@ -0,0 +1,42 @@
+#pragma once
+
+#include "platform.h"
+#include <glad/glad.h>
+
+//Binary cache of linked shader programs, read back with glProgramBinary instead of compiling
+//and linking the source again. One file per program is written next to its source, keyed
+//by a hash of the source, the defines it is compiled with, the driver (vendor, renderer and
+//version strings) and the binary formats the driver offers. Any mismatch, or a binary the
+//driver rejects, falls back to compiling from source and rewrites the cache.
+
+#define PROGRAM_CACHE_EXTENSION ".progcache"
+#define PROGRAM_CACHE_MAGIC 0x47525043u //"CPRG"
+#define PROGRAM_CACHE_VERSION 1
+
+struct ProgramCacheHeader
+{
+    u32 magic;
+    u32 version;
+    u64 key;
+    u32 binaryFormat;
+    u32 binarySize; //Bytes of binary right after the header
+};
+
+/**
+ * Cache key of a program compiled from source with the given preamble of #version and
+ * #define lines on the current driver. Returns 0, which disables the cache, when the driver
+ * offers no program binary formats.
+ */
+u64 ComputeProgramCacheKey(String source, const char* preamble);
+
+/**
+ * Creates a program from the cached binary of filepath/programName. Returns 0 if there is
+ * no cache for the key or the driver does not accept it.
+ */
+GLuint LoadProgramFromCache(const char* filepath, const char* programName, u64 key);
+
+/**
+ * Stores the binary of a linked program. The program has to be linked with
+ * GL_PROGRAM_BINARY_RETRIEVABLE_HINT set. Does nothing for a key of 0.
+ */
+void SaveProgramToCache(const char* filepath, const char* programName, u64 key, GLuint programHandle);
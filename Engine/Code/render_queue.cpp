@@ -0,0 +1,73 @@
+#include "render_queue.h"
+#include <string.h>
+#include <utility>
+
+#define SORT_KEY_FIELD(value, bits, shift) (((u64)(value) & ((1ull << (bits)) - 1)) << (shift))
+
+u64 MakeSortKey(u32 pass, u32 program, u32 vao, u32 texture, u32 instanceBlock, u32 material, f32 viewDepth)
+{
+    //The bits of a non negative float grow with its value, its top 16 bits are a coarse depth
+    u32 depthBits = 0;
+    if (viewDepth > 0.0f)
+        memcpy(&depthBits, &viewDepth, sizeof(depthBits));
+
+    return SORT_KEY_FIELD(pass, 4, 60) |
+        SORT_KEY_FIELD(program, 6, 54) |
+        SORT_KEY_FIELD(vao, 6, 48) |
+        SORT_KEY_FIELD(texture, 14, 34) |
+        SORT_KEY_FIELD(instanceBlock, 6, 28) |
+        SORT_KEY_FIELD(material, 12, 16) |
+        SORT_KEY_FIELD(depthBits >> 16, 16, 0);
+}
+
+void RadixSort(std::vector<u64>& keys, std::vector<u32>& values, std::vector<u64>& scratchKeys, std::vector<u32>& scratchValues)
+{
+    const u32 count = (u32)keys.size();
+    if (count < 2)
+        return;
+    scratchKeys.resize(count);
+    scratchValues.resize(count);
+
+    //All the histograms in one read
+    u32 histograms[8][256] = {};
+    for (u32 i = 0; i < count; ++i)
+        for (u32 digit = 0; digit < 8; ++digit)
+            ++histograms[digit][(keys[i] >> (digit * 8)) & 0xFF];
+
+    u64* sourceKeys = keys.data();
+    u32* sourceValues = values.data();
+    u64* destinationKeys = scratchKeys.data();
+    u32* destinationValues = scratchValues.data();
+    for (u32 digit = 0; digit < 8; ++digit)
+    {
+        u32* histogram = histograms[digit];
+        const u32 shift = digit * 8;
+        if (histogram[(sourceKeys[0] >> shift) & 0xFF] == count)
+            continue;
+
+        u32 offset = 0;
+        for (u32 bucket = 0; bucket < 256; ++bucket)
+        {
+            u32 bucketCount = histogram[bucket];
+            histogram[bucket] = offset;
+            offset += bucketCount;
+        }
+
+        for (u32 i = 0; i < count; ++i)
+        {
+            u32 position = histogram[(sourceKeys[i] >> shift) & 0xFF]++;
+            destinationKeys[position] = sourceKeys[i];
+            destinationValues[position] = sourceValues[i];
+        }
+
+        std::swap(sourceKeys, destinationKeys);
+        std::swap(sourceValues, destinationValues);
+    }
+
+    //An odd number of scatters leaves the result in the scratch vectors
+    if (sourceKeys != keys.data())
+    {
+        keys.swap(scratchKeys);
+        values.swap(scratchValues);
+    }
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "platform.h"
+
+//Draw ordering through 64 bit sort keys. The most significant fields are the most expensive
+//state to change, so sorting the keys clusters draws sharing a program, then a VAO, then a
+//texture; the depth in the lowest bits orders what is left front to back. Key layout, from
+//the top bit down:
+//    pass 4 | program 6 | VAO 6 | texture 14 | instance block 6 | material 12 | depth 16
+//Indices wider than their field wrap around. That only costs some clustering: the runs
+//drawn together are still decided by comparing the real state.
+
+struct RenderStateChanges
+{
+    u32 programs = 0;
+    u32 vaos = 0;
+    u32 textures = 0;
+    u32 instanceBuffers = 0;
+
+    u32 Total() const { return programs + vaos + textures + instanceBuffers; }
+};
+
+enum RenderPass
+{
+    RenderPass_Geometry = 0,
+    RenderPass_Count
+};
+
+/**
+ * Packs the draw state into a sort key, see the layout above. viewDepth is the distance
+ * along the view direction, negative values are treated as 0.
+ */
+u64 MakeSortKey(u32 pass, u32 program, u32 vao, u32 texture, u32 instanceBlock, u32 material, f32 viewDepth);
+
+/**
+ * Sorts keys in ascending order, applying the same permutation to values. LSD radix sort
+ * over 8 bit digits; the digits every key shares are skipped. The scratch vectors are
+ * resized as needed and can be kept between calls to avoid allocations.
+ */
+void RadixSort(std::vector<u64>& keys, std::vector<u32>& values, std::vector<u64>& scratchKeys, std::vector<u32>& scratchValues);
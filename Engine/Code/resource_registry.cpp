@@ -0,0 +1,92 @@
+#include "resource_registry.h"
+#include "engine.h"
+#include <string.h>
+
+u64 HashResourcePath(const char* filepath)
+{
+    return HashBytes(filepath, strlen(filepath));
+}
+
+u64 HashMaterial(const Material& material)
+{
+    u64 hash = HashBytes(&material.albedo, sizeof(material.albedo));
+    hash = HashBytes(&material.emissive, sizeof(material.emissive), hash);
+    hash = HashBytes(&material.specular, sizeof(material.specular), hash);
+    hash = HashBytes(&material.smoothness, sizeof(material.smoothness), hash);
+
+    const u32 textureIndices[] = {
+        material.albedoTextureIdx,
+        material.emissiveTextureIdx,
+        material.specularTextureIdx,
+        material.normalsTextureIdx,
+        material.bumpTextureIdx
+    };
+    return HashBytes(textureIndices, sizeof(textureIndices), hash);
+}
+
+static bool AreMaterialsEqual(const Material& a, const Material& b)
+{
+    return a.albedo == b.albedo && a.emissive == b.emissive && a.specular == b.specular &&
+        a.smoothness == b.smoothness &&
+        a.albedoTextureIdx == b.albedoTextureIdx &&
+        a.emissiveTextureIdx == b.emissiveTextureIdx &&
+        a.specularTextureIdx == b.specularTextureIdx &&
+        a.normalsTextureIdx == b.normalsTextureIdx &&
+        a.bumpTextureIdx == b.bumpTextureIdx;
+}
+
+u32 FindTexture2D(App* app, const char* filepath)
+{
+    auto it = app->registry.textureIndices.find(HashResourcePath(filepath));
+    if (it == app->registry.textureIndices.end())
+        return UINT32_MAX;
+
+    //Hash collisions are not worth a second level, the slower path simply loads it again
+    return app->textures[it->second].filepath == filepath ? it->second : UINT32_MAX;
+}
+
+u32 AddTexture2D(App* app, const Texture& texture)
+{
+    u32 texIdx = (u32)app->textures.size();
+    app->textures.push_back(texture);
+    app->registry.textureIndices[HashResourcePath(texture.filepath.c_str())] = texIdx;
+    return texIdx;
+}
+
+u32 AddMaterial(App* app, const Material& material)
+{
+    u64 hash = HashMaterial(material);
+    auto it = app->registry.materialIndices.find(hash);
+    if (it != app->registry.materialIndices.end() && AreMaterialsEqual(app->materials[it->second], material))
+    {
+        ++app->registry.reusedMaterialCount;
+        return it->second;
+    }
+
+    u32 materialIdx = (u32)app->materials.size();
+    app->materials.push_back(material);
+    app->registry.materialIndices[hash] = materialIdx;
+    return materialIdx;
+}
+
+void UploadMaterials(App* app)
+{
+    ResourceRegistry& registry = app->registry;
+    u32 materialCount = (u32)app->materials.size();
+    if (materialCount == registry.uploadedMaterialCount)
+        return;
+
+    std::vector<MaterialData> materialData(materialCount);
+    for (u32 i = 0; i < materialCount; ++i)
+    {
+        materialData[i].specular = app->materials[i].specular;
+        materialData[i].shininess = app->materials[i].smoothness;
+    }
+
+    if (!registry.materialBuffer)
+        glGenBuffers(1, &registry.materialBuffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, registry.materialBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, materialCount * sizeof(MaterialData), materialData.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    registry.uploadedMaterialCount = materialCount;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "platform.h"
+#include <glad/glad.h>
+#include <unordered_map>
+
+//Lookup tables over App::textures and App::materials so loading a resource that already
+//exists is O(1) and never creates a second GPU object for it.
+//Textures are keyed by the hash of their path, materials by the hash of their contents
+//(colors, smoothness and texture indices; the name is left out so identically set up
+//materials exported under different names are shared).
+//The material parameters read by the shaders are also mirrored in a storage buffer indexed
+//by material index, so draws select their material through their instance data.
+
+#define MATERIAL_BUFFER_BINDING 2
+
+struct App;
+struct Material;
+struct Texture;
+
+//std430 layout of a material in the storage buffer
+struct MaterialData
+{
+    glm::vec3 specular;
+    f32 shininess;
+};
+
+struct ResourceRegistry
+{
+    std::unordered_map<u64, u32> textureIndices;
+    std::unordered_map<u64, u32> materialIndices;
+    u32 reusedMaterialCount = 0;
+
+    GLuint materialBuffer = 0;
+    u32 uploadedMaterialCount = 0;
+};
+
+u64 HashResourcePath(const char* filepath);
+u64 HashMaterial(const Material& material);
+
+/**
+ * Returns the index of the texture loaded from filepath, UINT32_MAX if there is none.
+ */
+u32 FindTexture2D(App* app, const char* filepath);
+
+/**
+ * Appends a texture to App::textures and registers its path. Returns its index.
+ */
+u32 AddTexture2D(App* app, const Texture& texture);
+
+/**
+ * Returns the index of a material identical to the given one, appending it to
+ * App::materials first if there is none yet.
+ */
+u32 AddMaterial(App* app, const Material& material);
+
+/**
+ * Mirrors App::materials in the material storage buffer if materials were added since the
+ * last call. Materials never change once added, so nothing is uploaded otherwise.
+ */
+void UploadMaterials(App* app);
@@ -0,0 +1,449 @@
+#include "scene.h"
+#include "engine.h"
+#include <algorithm>
+#include <fstream>
+#include <math.h>
+#include <sstream>
+#include <stdlib.h>
+#include <unordered_map>
+
+static bool ReadVec3(std::istringstream& tokens, glm::vec3& value)
+{
+    return (bool)(tokens >> value.x >> value.y >> value.z);
+}
+
+static bool IsNumber(const std::string& token)
+{
+    char* end = NULL;
+    strtof(token.c_str(), &end);
+    return end != token.c_str() && *end == '\0';
+}
+
+static bool ParseEntity(std::istringstream& tokens, SceneEntity& entity)
+{
+    if (!(tokens >> entity.model) || !ReadVec3(tokens, entity.position))
+        return false;
+
+    std::vector<std::string> options;
+    for (std::string option; tokens >> option;)
+        options.push_back(option);
+
+    for (u32 i = 0; i < options.size(); ++i)
+    {
+        if (options[i] == "texture" && i + 1 < options.size())
+        {
+            entity.albedoTexture = options[++i];
+            continue;
+        }
+
+        u32 valueCount = 0;
+        while (i + 1 + valueCount < options.size() && IsNumber(options[i + 1 + valueCount]))
+            ++valueCount;
+
+        f32 values[3];
+        for (u32 j = 0; j < valueCount && j < 3; ++j)
+            values[j] = strtof(options[i + 1 + j].c_str(), NULL);
+
+        if (options[i] == "rotate" && valueCount == 3)
+            entity.rotation = glm::vec3(values[0], values[1], values[2]);
+        else if (options[i] == "scale" && valueCount == 3)
+            entity.scale = glm::vec3(values[0], values[1], values[2]);
+        else if (options[i] == "scale" && valueCount == 1)
+            entity.scale = glm::vec3(values[0]);
+        else if (options[i] == "variant" && valueCount == 1 && values[0] >= 0.0f)
+            entity.materialVariant = (u32)values[0];
+        else
+            return false;
+        i += valueCount;
+    }
+    return true;
+}
+
+static bool ParseLight(std::istringstream& tokens, SceneLight& light)
+{
+    std::string type;
+    if (!(tokens >> type) || (type != "point" && type != "directional") || !ReadVec3(tokens, light.vector))
+        return false;
+    light.isDirectional = type == "directional";
+
+    std::string option;
+    while (tokens >> option)
+    {
+        bool isValid = false;
+        if (option == "ambient")
+            isValid = ReadVec3(tokens, light.ambient);
+        else if (option == "diffuse")
+            isValid = ReadVec3(tokens, light.diffuse);
+        else if (option == "specular")
+            isValid = ReadVec3(tokens, light.specular);
+        else if (option == "constant")
+            isValid = (bool)(tokens >> light.constant);
+        if (!isValid)
+            return false;
+    }
+    return true;
+}
+
+bool ParseSceneDescription(const char* filepath, SceneDescription& scene)
+{
+    std::ifstream file(filepath);
+    if (!file)
+    {
+        ELOG("Could not open scene description %s", filepath);
+        return false;
+    }
+
+    std::string line;
+    for (u32 lineNumber = 1; std::getline(file, line); ++lineNumber)
+    {
+        size_t comment = line.find('#');
+        if (comment != std::string::npos)
+            line.resize(comment);
+
+        std::istringstream tokens(line);
+        std::string directive;
+        if (!(tokens >> directive))
+            continue;
+
+        bool isValid = false;
+        if (directive == "model")
+        {
+            SceneModel model;
+            isValid = (bool)(tokens >> model.name >> model.path);
+            scene.models.push_back(model);
+        }
+        else if (directive == "entity")
+        {
+            SceneEntity entity;
+            isValid = ParseEntity(tokens, entity);
+            scene.entities.push_back(entity);
+        }
+        else if (directive == "light")
+        {
+            SceneLight light;
+            isValid = ParseLight(tokens, light);
+            scene.lights.push_back(light);
+        }
+        else if (directive == "camera")
+        {
+            CameraKey key;
+            isValid = (bool)(tokens >> key.time) && ReadVec3(tokens, key.position) && (bool)(tokens >> key.yaw >> key.pitch);
+            scene.cameraPath.push_back(key);
+        }
+        else if (directive == "stress")
+        {
+            StressSceneOptions options;
+            std::string text;
+            isValid = (bool)(tokens >> text) && ParseStressSceneOptions(text.c_str(), options);
+            if (isValid)
+                GenerateStressScene(options, scene);
+        }
+
+        if (!isValid)
+        {
+            ELOG("%s(%u): invalid scene directive \"%s\"", filepath, lineNumber, line.c_str());
+            return false;
+        }
+    }
+
+    std::stable_sort(scene.cameraPath.begin(), scene.cameraPath.end(),
+        [](const CameraKey& a, const CameraKey& b) { return a.time < b.time; });
+    return true;
+}
+
+bool ParseStressSceneOptions(const char* text, StressSceneOptions& options)
+{
+    std::istringstream pairs(text);
+    for (std::string pair; std::getline(pairs, pair, ',');)
+    {
+        size_t equals = pair.find('=');
+        std::string key = pair.substr(0, equals);
+        std::string value = equals != std::string::npos ? pair.substr(equals + 1) : "";
+
+        bool isValid = !value.empty();
+        if (isValid && key == "model")
+            options.model = value;
+        else if (isValid && key == "layout" && (value == "grid" || value == "random"))
+            options.layout = value == "grid" ? StressLayout_Grid : StressLayout_Random;
+        else if (isValid && IsNumber(value))
+        {
+            f32 number = strtof(value.c_str(), NULL);
+            if (key == "instances" && number >= 0.0f)
+                options.instanceCount = (u32)number;
+            else if (key == "spacing" && number > 0.0f)
+                options.spacing = number;
+            else if (key == "lights" && number >= 0.0f)
+                options.pointLightCount = (u32)number;
+            else if (key == "materials" && number >= 1.0f)
+                options.materialCount = (u32)number;
+            else if (key == "seed" && number >= 0.0f)
+                options.seed = (u32)number;
+            else
+                isValid = false;
+        }
+        else
+            isValid = false;
+
+        if (!isValid)
+        {
+            ELOG("Invalid stress scene option \"%s\"", pair.c_str());
+            return false;
+        }
+    }
+    return true;
+}
+
+//xorshift32: the same sequence on every platform, unlike the std distributions
+static f32 NextRandom(u32& state)
+{
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return (state >> 8) * (1.0f / 16777216.0f);
+}
+
+//Evenly spread hues, the golden ratio keeps neighbouring indices apart
+static glm::vec3 GetDistinctColor(u32 index)
+{
+    f32 hue = fmodf(index * 0.618034f, 1.0f);
+    glm::vec3 phases = glm::vec3(0.0f, 1.0f / 3.0f, 2.0f / 3.0f);
+    return 0.5f + 0.5f * glm::cos(6.2831853f * (hue + phases));
+}
+
+void GenerateStressScene(const StressSceneOptions& options, SceneDescription& scene)
+{
+    u32 state = options.seed * 747796405u + 2891336453u;
+    u32 side = (u32)ceilf(sqrtf((f32)options.instanceCount));
+    f32 extent = glm::max(side, 1u) * options.spacing;
+
+    for (u32 i = 0; i < options.instanceCount; ++i)
+    {
+        SceneEntity entity;
+        entity.model = options.model;
+        entity.materialVariant = i % options.materialCount;
+        if (options.layout == StressLayout_Grid)
+        {
+            entity.position.x = ((i % side) - (side - 1) * 0.5f) * options.spacing;
+            entity.position.z = ((i / side) - (side - 1) * 0.5f) * options.spacing;
+        }
+        else
+        {
+            entity.position.x = (NextRandom(state) - 0.5f) * extent;
+            entity.position.z = (NextRandom(state) - 0.5f) * extent;
+            entity.rotation.y = NextRandom(state) * 360.0f;
+        }
+        scene.entities.push_back(entity);
+    }
+
+    //Ground and sun as in the built-in scene
+    SceneEntity ground;
+    ground.model = "plane";
+    ground.position = glm::vec3(0.0f, -3.5f, 0.0f);
+    ground.rotation = glm::vec3(-90.0f, 0.0f, 0.0f);
+    ground.scale = glm::vec3(extent + 20.0f);
+    scene.entities.push_back(ground);
+
+    SceneLight sun;
+    sun.isDirectional = true;
+    sun.vector = glm::vec3(-0.2f, -1.0f, -0.35f);
+    sun.ambient = glm::vec3(0.0f, 0.0f, 0.4f);
+    sun.diffuse = glm::vec3(0.25f);
+    sun.specular = glm::vec3(0.5f);
+    scene.lights.push_back(sun);
+
+    for (u32 i = 0; i < options.pointLightCount; ++i)
+    {
+        SceneLight light;
+        light.vector.x = (NextRandom(state) - 0.5f) * extent;
+        light.vector.y = 1.0f + NextRandom(state) * 5.0f;
+        light.vector.z = (NextRandom(state) - 0.5f) * extent;
+        light.ambient = GetDistinctColor(i) * 0.2f;
+        scene.lights.push_back(light);
+    }
+
+    //One orbit around the instances in ten seconds, looking at their center
+    if (scene.cameraPath.empty())
+    {
+        f32 radius = glm::max(extent * 0.75f, 10.0f);
+        f32 height = radius * 0.5f;
+        for (u32 i = 0; i <= 4; ++i)
+        {
+            f32 angle = i * 90.0f;
+            CameraKey key;
+            key.time = i * 2.5f;
+            key.position = glm::vec3(cosf(glm::radians(angle)) * radius, height, sinf(glm::radians(angle)) * radius);
+            key.yaw = angle + 180.0f;
+            key.pitch = -glm::degrees(atanf(height / radius));
+            scene.cameraPath.push_back(key);
+        }
+    }
+}
+
+//Variant textures are shared by every model using the variant
+static u32 CreateVariantTexture(App* app, u32 variant)
+{
+    //Checkerboard in a color of its own, large enough to cost some texture bandwidth
+    const i32 size = 64;
+    glm::vec3 color = GetDistinctColor(variant) * 255.0f;
+    std::vector<u8> pixels(size * size * 4);
+    for (i32 y = 0; y < size; ++y)
+    {
+        for (i32 x = 0; x < size; ++x)
+        {
+            f32 shade = ((x / 8 + y / 8) & 1) ? 1.0f : 0.6f;
+            u8* pixel = &pixels[(y * size + x) * 4];
+            pixel[0] = (u8)(color.r * shade);
+            pixel[1] = (u8)(color.g * shade);
+            pixel[2] = (u8)(color.b * shade);
+            pixel[3] = 255;
+        }
+    }
+
+    Image image = {};
+    image.pixels = pixels.data();
+    image.size = ivec2(size, size);
+    image.nchannels = 4;
+    image.stride = size * 4;
+
+    Texture texture;
+    texture.handle = CreateTexture2DFromImage(image);
+    texture.filepath = "generated/variant_" + std::to_string(variant);
+    return AddTexture2D(app, texture);
+}
+
+//A model sharing the mesh of another with its own copy of each material
+static u32 CreateModelVariant(App* app, u32 modelIdx, u32 albedoTextureIdx)
+{
+    Model variant = app->models[modelIdx];
+    for (u32& materialIdx : variant.materialIdx)
+    {
+        Material material = app->materials[materialIdx];
+        material.albedoTextureIdx = albedoTextureIdx;
+        materialIdx = AddMaterial(app, material);
+    }
+    app->models.push_back(variant);
+    return (u32)app->models.size() - 1u;
+}
+
+bool CreateScene(App* app, const SceneDescription& scene)
+{
+    std::unordered_map<std::string, u32> modelIndices;
+    modelIndices["patrick"] = app->patrickModelIdx;
+    modelIndices["plane"] = app->planeModelIdx;
+    for (const SceneModel& model : scene.models)
+    {
+        u32 modelIdx = LoadModel(app, model.path.c_str());
+        if (modelIdx == UINT32_MAX)
+            return false;
+        modelIndices[model.name] = modelIdx;
+    }
+
+    std::unordered_map<u32, u32> variantTextures;
+    std::unordered_map<u64, u32> variantModels; //Model index in the high bits, albedo texture in the low ones
+    for (const SceneEntity& entity : scene.entities)
+    {
+        auto it = modelIndices.find(entity.model);
+        if (it == modelIndices.end())
+        {
+            ELOG("Scene entity uses unknown model %s", entity.model.c_str());
+            return false;
+        }
+
+        //Streamed textures show white until they are uploaded, the scene starts meanwhile
+        u32 albedoTextureIdx = UINT32_MAX;
+        if (!entity.albedoTexture.empty())
+        {
+            albedoTextureIdx = StreamTexture2D(app, entity.albedoTexture.c_str(), app->whiteTexIdx);
+        }
+        else if (entity.materialVariant > 0)
+        {
+            auto textureIt = variantTextures.find(entity.materialVariant);
+            if (textureIt == variantTextures.end())
+                textureIt = variantTextures.emplace(entity.materialVariant, CreateVariantTexture(app, entity.materialVariant)).first;
+            albedoTextureIdx = textureIt->second;
+        }
+
+        u32 modelIdx = it->second;
+        if (albedoTextureIdx != UINT32_MAX)
+        {
+            u64 variantKey = ((u64)modelIdx << 32) | albedoTextureIdx;
+            auto variantIt = variantModels.find(variantKey);
+            if (variantIt == variantModels.end())
+                variantIt = variantModels.emplace(variantKey, CreateModelVariant(app, modelIdx, albedoTextureIdx)).first;
+            modelIdx = variantIt->second;
+        }
+
+        //Rotations that are not there are skipped so the matrices match hand built ones
+        glm::mat4 world = glm::translate(glm::mat4(1.0f), entity.position);
+        if (entity.rotation.y != 0.0f)
+            world = glm::rotate(world, glm::radians(entity.rotation.y), glm::vec3(0.0f, 1.0f, 0.0f));
+        if (entity.rotation.x != 0.0f)
+            world = glm::rotate(world, glm::radians(entity.rotation.x), glm::vec3(1.0f, 0.0f, 0.0f));
+        if (entity.rotation.z != 0.0f)
+            world = glm::rotate(world, glm::radians(entity.rotation.z), glm::vec3(0.0f, 0.0f, 1.0f));
+        if (entity.scale != glm::vec3(1.0f))
+            world = glm::scale(world, entity.scale);
+        AddEntity(app->entities, world, modelIdx);
+    }
+    UpdateCullingBounds(app);
+
+    if (scene.lights.size() > MAX_LIGHTS)
+        ELOG("Scene has %u lights, only the first %u are created", (u32)scene.lights.size(), MAX_LIGHTS);
+    for (const SceneLight& light : scene.lights)
+    {
+        if (app->lights.size() == MAX_LIGHTS)
+            break;
+        if (light.isDirectional)
+            app->lights.push_back(Light(LightType::Directional_Light, vec3(0.0f), light.vector, light.ambient, light.diffuse, light.specular, light.constant));
+        else
+            app->lights.push_back(Light(LightType::Point_Light, light.vector, vec3(0.0f), light.ambient, light.diffuse, light.specular, light.constant));
+    }
+
+    if (!scene.cameraPath.empty())
+    {
+        app->camera.cameraPos = scene.cameraPath[0].position;
+        app->camera.yaw = scene.cameraPath[0].yaw;
+        app->camera.pitch = scene.cameraPath[0].pitch;
+    }
+    return true;
+}
+
+static f32 CatmullRom(f32 p0, f32 p1, f32 p2, f32 p3, f32 t)
+{
+    return 0.5f * (2.0f * p1 + (p2 - p0) * t + (2.0f * p0 - 5.0f * p1 + 4.0f * p2 - p3) * t * t +
+        (3.0f * p1 - p0 - 3.0f * p2 + p3) * t * t * t);
+}
+
+CameraKey SampleCameraPath(const std::vector<CameraKey>& path, f32 time)
+{
+    if (path.empty())
+        return CameraKey();
+    if (time <= path.front().time)
+        return path.front();
+    if (time >= path.back().time)
+        return path.back();
+
+    u32 segment = 0;
+    while (path[segment + 1].time < time)
+        ++segment;
+
+    //The ends repeat their key so the curve starts and stops on them
+    const CameraKey& k0 = path[segment > 0 ? segment - 1 : segment];
+    const CameraKey& k1 = path[segment];
+    const CameraKey& k2 = path[segment + 1];
+    const CameraKey& k3 = path[segment + 2 < path.size() ? segment + 2 : segment + 1];
+    f32 t = k2.time > k1.time ? (time - k1.time) / (k2.time - k1.time) : 0.0f;
+
+    CameraKey key;
+    key.time = time;
+    for (u32 i = 0; i < 3; ++i)
+        key.position[i] = CatmullRom(k0.position[i], k1.position[i], k2.position[i], k3.position[i], t);
+    key.yaw = CatmullRom(k0.yaw, k1.yaw, k2.yaw, k3.yaw, t);
+    key.pitch = CatmullRom(k0.pitch, k1.pitch, k2.pitch, k3.pitch, t);
+    return key;
+}
+
+f32 GetCameraPathDuration(const std::vector<CameraKey>& path)
+{
+    return path.size() < 2 ? 0.0f : path.back().time;
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+#include "platform.h"
+
+//Scene descriptions: text files listing the models, entities, lights and camera path of a
+//scene, so benchmarks run on something other than the built-in scene of Init. One directive
+//per line, '#' starts a comment:
+//
+//  model <name> <path>                     Loads a model. "patrick" and "plane" always exist
+//  entity <model> <x y z> [rotate <x y z>] [scale <s | x y z>] [variant <n>] [texture <path>]
+//                                          Rotations in degrees, applied Y, X then Z
+//  light point <x y z> [options]
+//  light directional <dx dy dz> [options]  Options: ambient/diffuse/specular <r g b>, constant <c>
+//  camera <time> <x y z> <yaw> <pitch>     A key of the camera path, times in seconds
+//  stress <key=value,...>                  Adds a generated stress scene, see StressSceneOptions
+//
+//The camera path is a Catmull-Rom spline through its keys. Entity variants other than 0 use
+//copies of the materials of their model, each variant with its own generated albedo texture,
+//so scenes can have as many unique materials and textures as they need. A texture replaces
+//the albedo textures of the model instead and is streamed (texture_streaming.h): the scene
+//renders with white in its place until it is uploaded.
+//At most MAX_LIGHTS lights are created.
+
+struct App;
+
+struct SceneModel
+{
+    std::string name;
+    std::string path;
+};
+
+struct SceneEntity
+{
+    std::string model;
+    glm::vec3 position = glm::vec3(0.0f);
+    glm::vec3 rotation = glm::vec3(0.0f); //Degrees
+    glm::vec3 scale = glm::vec3(1.0f);
+    u32 materialVariant = 0;
+    std::string albedoTexture; //Streamed in place of the model albedo textures when set
+};
+
+struct SceneLight
+{
+    bool isDirectional = false;
+    glm::vec3 vector = glm::vec3(0.0f); //Position of point lights, direction of directional ones
+    glm::vec3 ambient = glm::vec3(0.0f);
+    glm::vec3 diffuse = glm::vec3(0.5f);
+    glm::vec3 specular = glm::vec3(1.0f);
+    f32 constant = 1.0f;
+};
+
+struct CameraKey
+{
+    f32 time = 0.0f;
+    glm::vec3 position = glm::vec3(0.0f);
+    f32 yaw = -90.0f;
+    f32 pitch = 0.0f;
+};
+
+struct SceneDescription
+{
+    std::vector<SceneModel> models;
+    std::vector<SceneEntity> entities;
+    std::vector<SceneLight> lights;
+    std::vector<CameraKey> cameraPath; //Sorted by time
+};
+
+enum StressLayout
+{
+    StressLayout_Grid,
+    StressLayout_Random
+};
+
+//Scaling tests: N instances of a model, M point lights over them and K unique materials.
+//Written as "instances=1000,lights=32,materials=16,layout=random" on the command line and
+//in stress directives.
+struct StressSceneOptions
+{
+    std::string model = "patrick";
+    u32 instanceCount = 100;
+    StressLayout layout = StressLayout_Grid;
+    f32 spacing = 4.0f;       //Distance between grid cells, random layouts cover the same area
+    u32 pointLightCount = 8;
+    u32 materialCount = 1;    //Entity i uses variant i % materialCount, 1: the model materials only
+    u32 seed = 1;             //Random layouts, light positions and colors
+};
+
+/**
+ * Reads a scene description. Logs the offending line and returns false on errors.
+ */
+bool ParseSceneDescription(const char* filepath, SceneDescription& scene);
+
+/**
+ * Parses a comma separated list of key=value pairs over the given options. Keys are
+ * model, instances, layout (grid or random), spacing, lights, materials and seed.
+ * Logs the offending pair and returns false on errors.
+ */
+bool ParseStressSceneOptions(const char* text, StressSceneOptions& options);
+
+/**
+ * Appends the instances, a ground plane, a directional light and the point lights of a
+ * stress scene, plus a camera orbit around them if the scene has no camera path yet.
+ * The same options always generate the same scene.
+ */
+void GenerateStressScene(const StressSceneOptions& options, SceneDescription& scene);
+
+/**
+ * Loads the models of the scene and adds its entities and lights to the app, placing the
+ * camera at the start of its path. Called by Init in place of the built-in scene when
+ * App::scene is set.
+ */
+bool CreateScene(App* app, const SceneDescription& scene);
+
+/**
+ * Camera placement at the given time, clamped to the ends of the path.
+ */
+CameraKey SampleCameraPath(const std::vector<CameraKey>& path, f32 time);
+
+/**
+ * Time of the last key, 0 for paths with less than two keys.
+ */
+f32 GetCameraPathDuration(const std::vector<CameraKey>& path);
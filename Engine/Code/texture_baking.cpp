@@ -0,0 +1,134 @@
+#include "texture_baking.h"
+
+std::string GetBakedTexturePath(const char* sourcePath)
+{
+    return std::string(sourcePath) + BAKED_TEXTURE_EXTENSION;
+}
+
+u32 GetBakedTextureBlockSize(u32 format)
+{
+    switch (format)
+    {
+        case BakedTexture_BC1: return 8;
+        case BakedTexture_BC3: return 16;
+        case BakedTexture_BC4: return 8;
+        case BakedTexture_BC5: return 16;
+        default: return 0;
+    }
+}
+
+static GLenum GetBakedTextureInternalFormat(u32 format)
+{
+    switch (format)
+    {
+        case BakedTexture_BC1: return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+        case BakedTexture_BC3: return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+        case BakedTexture_BC4: return GL_COMPRESSED_RED_RGTC1;
+        case BakedTexture_BC5: return GL_COMPRESSED_RG_RGTC2;
+        default: return GL_NONE;
+    }
+}
+
+static bool IsBakedTextureFormatSupported(u32 format)
+{
+    //RGTC is core since 3.0, S3TC is still an extension
+    if (format == BakedTexture_BC1 || format == BakedTexture_BC3)
+        return GLAD_GL_EXT_texture_compression_s3tc != 0;
+    return format < BakedTexture_Count;
+}
+
+static bool ValidateBakedTexture(const MappedFile& file, const BakedTextureHeader* header, const BakedTextureMip* mips)
+{
+    if (file.size < sizeof(BakedTextureHeader) || header->magic != BAKED_TEXTURE_MAGIC || header->version != BAKED_TEXTURE_VERSION)
+        return false;
+
+    if (header->mipCount == 0 || header->mipCount > BAKED_TEXTURE_MAX_MIPS ||
+        file.size < sizeof(BakedTextureHeader) + header->mipCount * sizeof(BakedTextureMip))
+        return false;
+
+    for (u32 i = 0; i < header->mipCount; ++i)
+        if ((u64)mips[i].offset + mips[i].size > file.size)
+            return false;
+
+    return true;
+}
+
+bool LoadBakedTexture(const char* sourcePath, BakedTexture& baked)
+{
+    baked = {};
+
+    std::string bakedPath = GetBakedTexturePath(sourcePath);
+    MappedFile file = MapFile(bakedPath.c_str());
+    if (!file.data)
+        return false;
+
+    const BakedTextureHeader* header = (const BakedTextureHeader*)file.data;
+    const BakedTextureMip* mips = (const BakedTextureMip*)(file.data + sizeof(BakedTextureHeader));
+    if (!ValidateBakedTexture(file, header, mips))
+    {
+        ELOG("Ignoring invalid baked texture %s", bakedPath.c_str());
+        UnmapFile(file);
+        return false;
+    }
+
+    if (!IsBakedTextureFormatSupported(header->format))
+    {
+        UnmapFile(file);
+        return false;
+    }
+
+    //Builds may ship the baked file alone, otherwise it has to match its source
+    MappedFile source = MapFile(sourcePath);
+    if (source.data)
+    {
+        u64 sourceHash = HashBytes(source.data, source.size);
+        UnmapFile(source);
+        if (sourceHash != header->sourceHash)
+        {
+            ILOG("Baked texture %s is outdated, loading %s", bakedPath.c_str(), sourcePath);
+            UnmapFile(file);
+            return false;
+        }
+    }
+
+    baked.file = file;
+    baked.header = header;
+    baked.mips = mips;
+    return true;
+}
+
+void FreeBakedTexture(BakedTexture& baked)
+{
+    UnmapFile(baked.file);
+    baked = {};
+}
+
+GLuint CreateTexture2DFromBaked(const BakedTexture& baked)
+{
+    const BakedTextureHeader& header = *baked.header;
+    GLenum internalFormat = GetBakedTextureInternalFormat(header.format);
+
+    GLuint texHandle;
+    glGenTextures(1, &texHandle);
+    glBindTexture(GL_TEXTURE_2D, texHandle);
+    for (u32 level = 0; level < header.mipCount; ++level)
+    {
+        const BakedTextureMip& mip = baked.mips[level];
+        glCompressedTexImage2D(GL_TEXTURE_2D, level, internalFormat, mip.width, mip.height, 0, mip.size, baked.file.data + mip.offset);
+    }
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, header.mipCount - 1);
+    if (header.format == BakedTexture_BC4)
+    {
+        //Grayscale: the single channel is read as rgb, not as red
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_G, GL_RED);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_B, GL_RED);
+    }
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    return texHandle;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "platform.h"
+#include <glad/glad.h>
+
+//Baked texture container written by the offline texture_baker tool: a block-compressed
+//image with its whole mip chain precomputed, stored next to the source image as
+//<source>.btex. When it matches the source contents it is uploaded as is instead of
+//decoding the source and generating the mips at load time.
+//Layout: header | mip records | mip data (level 0 first). Native endianness.
+
+#define BAKED_TEXTURE_EXTENSION ".btex"
+#define BAKED_TEXTURE_MAGIC 0x58455442u //"BTEX"
+#define BAKED_TEXTURE_VERSION 1
+#define BAKED_TEXTURE_MAX_MIPS 16
+
+enum BakedTextureFormat
+{
+    BakedTexture_BC1 = 0,   //RGB, 4 bpp
+    BakedTexture_BC3,       //RGBA, 8 bpp
+    BakedTexture_BC4,       //R (RGTC1), 4 bpp, swizzled to grayscale on upload
+    BakedTexture_BC5,       //RG (RGTC2), 8 bpp, only on request: samples read (r, g, 0)
+    BakedTexture_Count
+};
+
+struct BakedTextureHeader
+{
+    u32 magic;
+    u32 version;
+    u64 sourceHash;
+    u32 format;
+    u32 width;
+    u32 height;
+    u32 mipCount;
+};
+
+struct BakedTextureMip
+{
+    u32 width;
+    u32 height;
+    u32 offset; //From the start of the file
+    u32 size;
+};
+
+struct BakedTexture
+{
+    MappedFile file;
+    const BakedTextureHeader* header;
+    const BakedTextureMip* mips;
+};
+
+std::string GetBakedTexturePath(const char* sourcePath);
+
+/**
+ * Bytes taken by one 4x4 block of the given format.
+ */
+u32 GetBakedTextureBlockSize(u32 format);
+
+/**
+ * Maps the baked version of sourcePath. Fails if there is none, if it is outdated with
+ * respect to the source or if the driver cannot sample its format. Thread safe.
+ */
+bool LoadBakedTexture(const char* sourcePath, BakedTexture& baked);
+
+void FreeBakedTexture(BakedTexture& baked);
+
+/**
+ * Creates a texture from the precomputed mips with glCompressedTexImage2D.
+ */
+GLuint CreateTexture2DFromBaked(const BakedTexture& baked);
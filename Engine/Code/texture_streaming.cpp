@@ -0,0 +1,336 @@
+#include "texture_streaming.h"
+#include "engine.h"
+#include <atomic>
+
+enum TextureStreamState
+{
+    TextureStream_Decoding = 0,
+    TextureStream_Decoded,
+    TextureStream_Copying,
+    TextureStream_Copied,
+    TextureStream_Failed
+};
+
+struct TextureStreamRequest
+{
+    std::string filepath;
+    u32 textureIdx = UINT32_MAX;
+    u32 pboIdx = UINT32_MAX;
+    GLuint texHandle = 0; //Allocated up front, filled from the PBO
+    Image image = {};
+    BakedTexture baked = {};
+    std::atomic<u32> state;
+};
+
+void InitTextureStreamer(TextureStreamer& streamer, JobSystem& jobs)
+{
+    streamer.jobs = &jobs;
+
+    streamer.isPersistentMapping = GLAD_GL_ARB_buffer_storage != 0;
+    if (!streamer.isPersistentMapping)
+    {
+        ILOG("GL_ARB_buffer_storage not available: streamed textures will be uploaded without PBOs");
+        return;
+    }
+
+    const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    for (u32 i = 0; i < TEXTURE_STREAM_PBO_COUNT; ++i)
+    {
+        TextureStreamPBO& pbo = streamer.pbos[i];
+        glGenBuffers(1, &pbo.handle);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo.handle);
+        glBufferStorage(GL_PIXEL_UNPACK_BUFFER, TEXTURE_STREAM_PBO_SIZE, nullptr, flags);
+        pbo.data = (u8*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, TEXTURE_STREAM_PBO_SIZE, flags);
+        streamer.isPersistentMapping &= pbo.data != nullptr;
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    if (!streamer.isPersistentMapping)
+        ELOG("Could not map the texture streaming PBOs: streamed textures will be uploaded without PBOs");
+}
+
+void DestroyTextureStreamer(TextureStreamer& streamer)
+{
+    if (streamer.jobs)
+        WaitForCounter(*streamer.jobs, streamer.jobsInFlight);
+    streamer.jobs = NULL;
+
+    for (TextureStreamRequest* request : streamer.requests)
+    {
+        if (request->image.pixels)
+            FreeImage(request->image);
+        if (request->baked.file.data)
+            FreeBakedTexture(request->baked);
+        if (request->texHandle)
+            glDeleteTextures(1, &request->texHandle);
+        delete request;
+    }
+    streamer.requests.clear();
+
+    //Deleting a buffer also releases its mapping
+    for (u32 i = 0; i < TEXTURE_STREAM_PBO_COUNT; ++i)
+    {
+        TextureStreamPBO& pbo = streamer.pbos[i];
+        if (pbo.fence)
+            glDeleteSync(pbo.fence);
+        if (pbo.handle)
+            glDeleteBuffers(1, &pbo.handle);
+        pbo = TextureStreamPBO();
+    }
+}
+
+u32 StreamTexture2D(App* app, const char* filepath, u32 placeholderTexIdx)
+{
+    u32 texIdx = FindTexture2D(app, filepath);
+    if (texIdx != UINT32_MAX)
+        return texIdx;
+
+    Texture tex = {};
+    tex.handle = app->textures[placeholderTexIdx].handle;
+    tex.filepath = filepath;
+    texIdx = AddTexture2D(app, tex);
+
+    TextureStreamRequest* request = new TextureStreamRequest();
+    request->filepath = filepath;
+    request->textureIdx = texIdx;
+    request->state = TextureStream_Decoding;
+    app->textureStreamer.requests.push_back(request);
+
+    RunJob(*app->textureStreamer.jobs, [request]
+    {
+        if (LoadBakedTexture(request->filepath.c_str(), request->baked))
+        {
+            request->state = TextureStream_Decoded;
+            return;
+        }
+        request->image = LoadImage(request->filepath.c_str());
+        request->state = request->image.pixels ? TextureStream_Decoded : TextureStream_Failed;
+    }, &app->textureStreamer.jobsInFlight);
+
+    return texIdx;
+}
+
+static u32 GetMipCount(ivec2 size)
+{
+    u32 mipCount = 1;
+    for (i32 extent = glm::max(size.x, size.y); extent > 1; extent /= 2)
+        ++mipCount;
+    return mipCount;
+}
+
+static ivec2 GetMipSize(ivec2 size, u32 mip)
+{
+    return glm::max(ivec2(size.x >> mip, size.y >> mip), ivec2(1));
+}
+
+//The levels are packed back to back in the PBO with tightly packed rows
+static u64 GetMipChainSize(ivec2 size, u32 channelCount)
+{
+    u64 chainSize = 0;
+    for (u32 mip = 0; mip < GetMipCount(size); ++mip)
+    {
+        ivec2 mipSize = GetMipSize(size, mip);
+        chainSize += (u64)mipSize.x * mipSize.y * channelCount;
+    }
+    return chainSize;
+}
+
+//Box filter of the 2x2 source texels under each destination texel, clamped at odd edges
+static void DownsampleMip(const u8* source, ivec2 sourceSize, u8* destination, ivec2 destinationSize, u32 channelCount)
+{
+    for (i32 y = 0; y < destinationSize.y; ++y)
+    {
+        i32 y0 = glm::min(y * 2, sourceSize.y - 1);
+        i32 y1 = glm::min(y * 2 + 1, sourceSize.y - 1);
+        for (i32 x = 0; x < destinationSize.x; ++x)
+        {
+            i32 x0 = glm::min(x * 2, sourceSize.x - 1);
+            i32 x1 = glm::min(x * 2 + 1, sourceSize.x - 1);
+            for (u32 c = 0; c < channelCount; ++c)
+            {
+                u32 sum = source[(y0 * sourceSize.x + x0) * channelCount + c] + source[(y0 * sourceSize.x + x1) * channelCount + c] +
+                    source[(y1 * sourceSize.x + x0) * channelCount + c] + source[(y1 * sourceSize.x + x1) * channelCount + c];
+                destination[(y * destinationSize.x + x) * channelCount + c] = (u8)((sum + 2) / 4);
+            }
+        }
+    }
+}
+
+//Runs on a job: level 0 is copied from the decoded image, every other level is filtered
+//from the previous one, so the main thread never generates mips
+static void WriteMipChain(const Image& image, u8* destination)
+{
+    const u32 channelCount = (u32)image.nchannels;
+    const u8* source = (const u8*)image.pixels;
+    for (i32 y = 0; y < image.size.y; ++y)
+        memcpy(destination + (u64)y * image.size.x * channelCount, source + (u64)y * image.stride, image.size.x * channelCount);
+
+    u8* previous = destination;
+    for (u32 mip = 1; mip < GetMipCount(image.size); ++mip)
+    {
+        ivec2 previousSize = GetMipSize(image.size, mip - 1);
+        ivec2 mipSize = GetMipSize(image.size, mip);
+        u8* current = previous + (u64)previousSize.x * previousSize.y * channelCount;
+        DownsampleMip(previous, previousSize, current, mipSize, channelCount);
+        previous = current;
+    }
+}
+
+static bool IsFenceSignalled(GLsync fence)
+{
+    GLenum result = glClientWaitSync(fence, 0, 0);
+    return result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED;
+}
+
+static u32 FindFreePBO(TextureStreamer& streamer)
+{
+    for (u32 i = 0; i < TEXTURE_STREAM_PBO_COUNT; ++i)
+    {
+        TextureStreamPBO& pbo = streamer.pbos[i];
+        if (!pbo.isCopying && !pbo.fence)
+            return i;
+    }
+    return UINT32_MAX;
+}
+
+void UpdateTextureStreaming(App* app)
+{
+    TextureStreamer& streamer = app->textureStreamer;
+
+    //--Recycle the PBOs whose upload has been consumed by the GPU--
+    for (u32 i = 0; i < TEXTURE_STREAM_PBO_COUNT; ++i)
+    {
+        TextureStreamPBO& pbo = streamer.pbos[i];
+        if (pbo.fence && IsFenceSignalled(pbo.fence))
+        {
+            glDeleteSync(pbo.fence);
+            pbo.fence = 0;
+        }
+    }
+
+    //--Advance the requests--
+    for (u32 i = 0; i < streamer.requests.size();)
+    {
+        TextureStreamRequest* request = streamer.requests[i];
+        GLuint texHandle = 0;
+
+        switch (request->state)
+        {
+            case TextureStream_Decoded:
+            {
+                //Baked mips are uploaded straight from their file mapping
+                if (request->baked.file.data)
+                {
+                    texHandle = CreateTexture2DFromBaked(request->baked);
+                    FreeBakedTexture(request->baked);
+                    break;
+                }
+
+                const Image& image = request->image;
+                u64 chainSize = GetMipChainSize(image.size, (u32)image.nchannels);
+                bool isSupportedFormat = image.nchannels == 3 || image.nchannels == 4;
+                if (!streamer.isPersistentMapping || !isSupportedFormat || chainSize > TEXTURE_STREAM_PBO_SIZE)
+                {
+                    texHandle = CreateTexture2DFromImage(request->image);
+                    FreeImage(request->image);
+                    request->image.pixels = nullptr;
+                    break;
+                }
+
+                u32 pboIdx = FindFreePBO(streamer);
+                if (pboIdx == UINT32_MAX)
+                    break;
+
+                request->pboIdx = pboIdx;
+                request->state = TextureStream_Copying;
+                streamer.pbos[pboIdx].isCopying = true;
+
+                //Allocating the storage is cheap, the pixels come later from the PBO
+                glGenTextures(1, &request->texHandle);
+                glBindTexture(GL_TEXTURE_2D, request->texHandle);
+                glTexStorage2D(GL_TEXTURE_2D, GetMipCount(image.size), image.nchannels == 4 ? GL_RGBA8 : GL_RGB8, image.size.x, image.size.y);
+                glBindTexture(GL_TEXTURE_2D, 0);
+
+                u8* destination = streamer.pbos[pboIdx].data;
+                RunJob(*streamer.jobs, [request, destination]
+                {
+                    WriteMipChain(request->image, destination);
+                    FreeImage(request->image);
+                    request->image.pixels = nullptr;
+                    request->state = TextureStream_Copied;
+                }, &streamer.jobsInFlight);
+            } break;
+
+            case TextureStream_Copied:
+            {
+                //The mapping is coherent, so the job's writes are visible to the upload. Each
+                //level sources the PBO, so the calls only queue the transfers
+                TextureStreamPBO& pbo = streamer.pbos[request->pboIdx];
+                const Image& image = request->image;
+                const GLenum dataFormat = image.nchannels == 4 ? GL_RGBA : GL_RGB;
+
+                glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo.handle);
+                glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+                glBindTexture(GL_TEXTURE_2D, request->texHandle);
+                u64 offset = 0;
+                for (u32 mip = 0; mip < GetMipCount(image.size); ++mip)
+                {
+                    ivec2 mipSize = GetMipSize(image.size, mip);
+                    glTexSubImage2D(GL_TEXTURE_2D, mip, 0, 0, mipSize.x, mipSize.y, dataFormat, GL_UNSIGNED_BYTE, (const void*)(uintptr_t)offset);
+                    offset += (u64)mipSize.x * mipSize.y * image.nchannels;
+                }
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+                glBindTexture(GL_TEXTURE_2D, 0);
+                glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+                glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+                texHandle = request->texHandle;
+
+                pbo.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+                pbo.isCopying = false;
+            } break;
+
+            case TextureStream_Failed:
+            {
+                ELOG("Could not stream texture %s, keeping its placeholder", request->filepath.c_str());
+                ++streamer.failedRequests;
+                streamer.requests.erase(streamer.requests.begin() + i);
+                delete request;
+            } continue;
+
+            default:
+                break;
+        }
+
+        if (texHandle)
+        {
+            app->textures[request->textureIdx].handle = texHandle;
+            streamer.requests.erase(streamer.requests.begin() + i);
+            delete request;
+            continue;
+        }
+        ++i;
+    }
+}
+
+void FlushTextureStreaming(App* app)
+{
+    while (!app->textureStreamer.requests.empty())
+    {
+        UpdateTextureStreaming(app);
+
+        //Helps running the decode and copy jobs, so this also works without workers
+        WaitForCounter(*app->textureStreamer.jobs, app->textureStreamer.jobsInFlight);
+
+        //Fences are only signalled once their commands reach the GPU
+        glFlush();
+        std::this_thread::yield();
+    }
+}
+
+u32 GetPendingTextureStreamCount(const TextureStreamer& streamer)
+{
+    return (u32)streamer.requests.size();
+}
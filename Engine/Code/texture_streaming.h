@@ -0,0 +1,70 @@
+#pragma once
+
+#include "job_system.h"
+#include <glad/glad.h>
+
+//Asynchronous texture uploads for textures requested mid-session. A request goes through
+//three steps so the frame never waits on it:
+//  1. a job decodes the image file (a baked texture is only mapped, and uploaded from
+//     its mapping as soon as it is ready),
+//  2. the main thread allocates the texture storage and a job writes the pixels and their
+//     mip chain, filtered on the CPU, into a free PBO of the ring (persistently mapped),
+//  3. the main thread issues a glTexSubImage2D per level sourcing the PBO and fences them;
+//     the driver transfers the data asynchronously and the PBO is reused once the fence is
+//     signalled.
+//Images that don't fit in a PBO, and every image without GL_ARB_buffer_storage, are
+//uploaded from client memory by CreateTexture2DFromImage instead.
+//Until a request completes its texture index points to a placeholder texture.
+
+#define TEXTURE_STREAM_PBO_COUNT 3
+#define TEXTURE_STREAM_PBO_SIZE MB(16)
+
+struct App;
+struct TextureStreamRequest;
+
+struct TextureStreamPBO
+{
+    GLuint handle = 0;
+    u8* data = nullptr;
+    GLsync fence = 0;
+    bool isCopying = false;
+};
+
+struct TextureStreamer
+{
+    JobSystem* jobs = NULL;     //The decode and copy jobs run on the engine job system
+    JobCounter jobsInFlight;
+    TextureStreamPBO pbos[TEXTURE_STREAM_PBO_COUNT];
+    std::vector<TextureStreamRequest*> requests;
+    bool isPersistentMapping = false;
+    u32 failedRequests = 0;
+};
+
+/**
+ * Creates the PBO ring. Without GL_ARB_buffer_storage requests are still decoded by jobs but
+ * uploaded straight from client memory. The job system has to outlive the streamer.
+ */
+void InitTextureStreamer(TextureStreamer& streamer, JobSystem& jobs);
+
+/**
+ * Waits for the in-flight jobs, then releases the requests and the PBO ring.
+ */
+void DestroyTextureStreamer(TextureStreamer& streamer);
+
+/**
+ * Queues a texture load and returns its index right away. The texture shows
+ * placeholderTexIdx until the upload has been issued.
+ */
+u32 StreamTexture2D(App* app, const char* filepath, u32 placeholderTexIdx);
+
+/**
+ * Advances the pending requests. Called once per frame from the GL thread, it never blocks.
+ */
+void UpdateTextureStreaming(App* app);
+
+/**
+ * Blocks until every pending request has been uploaded.
+ */
+void FlushTextureStreaming(App* app);
+
+u32 GetPendingTextureStreamCount(const TextureStreamer& streamer);
@@ -0,0 +1,703 @@
+#include "benchmark.h"
+#include "culling.h"
+#include "entity_store.h"
+#include "job_system.h"
+#include "mesh_cache.h"
+#include "render_queue.h"
+#include "scene.h"
+#include "bc_encoder.h"
+#include <algorithm>
+#include <float.h>
+#include <random>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+//Unit tests of the CPU side of the engine: everything that can run without a GL context.
+//Every test is a function checking its results with CHECK, which logs the failures and lets
+//the test go on. The run fails if any check failed.
+//Usage: engine_tests [name filter]. It writes its temporary files in the current directory.
+
+static u32 s_failedChecks = 0;
+
+static void ReportFailedCheck(const char* file, int line, const char* condition)
+{
+    fprintf(stderr, "%s(%d): CHECK(%s) failed\n", file, line, condition);
+    ++s_failedChecks;
+}
+
+#define CHECK(condition)                                  \
+{                                                         \
+if (!(condition))                                         \
+    ReportFailedCheck(__FILE__, __LINE__, #condition);    \
+}
+
+static bool WriteTextFile(const char* filepath, const char* text)
+{
+    FILE* file = fopen(filepath, "wb");
+    if (!file)
+        return false;
+    fputs(text, file);
+    fclose(file);
+    return true;
+}
+
+//--Render queue--
+static void TestSortKeys()
+{
+    //Every field outweighs all the ones below it
+    u64 base = MakeSortKey(0, 1, 1, 1, 1, 1, 1.0f);
+    CHECK(MakeSortKey(1, 0, 0, 0, 0, 0, 0.0f) > MakeSortKey(0, 63, 63, 16383, 63, 4095, 1.0e30f));
+    CHECK(MakeSortKey(0, 2, 0, 0, 0, 0, 0.0f) > base);
+    CHECK(MakeSortKey(0, 1, 2, 0, 0, 0, 0.0f) > base);
+    CHECK(MakeSortKey(0, 1, 1, 2, 0, 0, 0.0f) > base);
+    CHECK(MakeSortKey(0, 1, 1, 1, 2, 0, 0.0f) > base);
+    CHECK(MakeSortKey(0, 1, 1, 1, 1, 2, 0.0f) > base);
+
+    //Front to back, negative depths clamp to 0
+    CHECK(MakeSortKey(0, 1, 1, 1, 1, 1, 10.0f) > base);
+    CHECK(MakeSortKey(0, 1, 1, 1, 1, 1, -5.0f) == MakeSortKey(0, 1, 1, 1, 1, 1, 0.0f));
+    CHECK(MakeSortKey(0, 1, 1, 1, 1, 1, 0.0f) < base);
+
+    //Wider indices wrap inside their field instead of spilling into the next one
+    CHECK(MakeSortKey(0, 64, 0, 0, 0, 0, 0.0f) == MakeSortKey(0, 0, 0, 0, 0, 0, 0.0f));
+}
+
+static void TestRadixSort()
+{
+    std::mt19937_64 random(7);
+    std::vector<u64> scratchKeys;
+    std::vector<u32> scratchValues;
+
+    //Sizes below 2 are no-ops, shared high bytes skip their digits, which changes how many
+    //scatters run and so which buffer ends up holding the result
+    const u32 counts[] = { 0, 1, 2, 3, 100, 1000, 4097 };
+    const u64 masks[] = { ~0ull, 0xFFFFull, 0xFF00FF00FF00ull, 0xFFull << 56 };
+    for (u32 count : counts)
+    {
+        for (u64 mask : masks)
+        {
+            std::vector<u64> keys(count);
+            std::vector<u32> values(count);
+            for (u32 i = 0; i < count; ++i)
+            {
+                keys[i] = random() & mask;
+                values[i] = i;
+            }
+            std::vector<u64> original = keys;
+            std::vector<u64> expected = keys;
+            std::sort(expected.begin(), expected.end());
+
+            RadixSort(keys, values, scratchKeys, scratchValues);
+            CHECK(keys == expected);
+
+            //Values follow their keys and equal keys keep their order
+            bool valuesFollow = values.size() == count;
+            for (u32 i = 0; valuesFollow && i < count; ++i)
+            {
+                valuesFollow = values[i] < count && original[values[i]] == keys[i];
+                if (valuesFollow && i > 0 && keys[i - 1] == keys[i])
+                    valuesFollow = values[i - 1] < values[i];
+            }
+            CHECK(valuesFollow);
+        }
+    }
+}
+
+//--Entity store--
+static void TestEntityHandles()
+{
+    EntityStore store;
+    EntityHandle a = AddEntity(store, glm::mat4(1.0f), 10);
+    EntityHandle b = AddEntity(store, glm::mat4(2.0f), 11);
+    EntityHandle c = AddEntity(store, glm::mat4(3.0f), 12);
+    CHECK(store.count == 3);
+    CHECK(GetEntityIndex(store, b) == 1);
+
+    //The last entity moves into the hole and keeps its handle
+    CHECK(RemoveEntity(store, a));
+    CHECK(store.count == 2);
+    CHECK(!IsEntityAlive(store, a));
+    CHECK(GetEntityIndex(store, c) == 0);
+    CHECK(store.modelIndices[0] == 12);
+    CHECK(store.worldMatrices[0] == glm::mat4(3.0f));
+    CHECK(GetEntityIndex(store, b) == 1);
+    CHECK(!RemoveEntity(store, a));
+
+    //A reused slot gets a new generation, the stale handle stays dead
+    EntityHandle d = AddEntity(store, glm::mat4(4.0f), 13);
+    CHECK(d.slot == a.slot);
+    CHECK(d.generation != a.generation);
+    CHECK(!IsEntityAlive(store, a));
+    CHECK(GetEntityIndex(store, d) == 2);
+
+    for (u32 i = 0; i < store.count; ++i)
+    {
+        EntityHandle handle = GetEntityHandle(store, i);
+        CHECK(GetEntityIndex(store, handle) == i);
+    }
+
+    EntityHandle invalid;
+    CHECK(!IsEntityAlive(store, invalid));
+
+    CHECK(RemoveEntity(store, b));
+    CHECK(RemoveEntity(store, c));
+    CHECK(RemoveEntity(store, d));
+    CHECK(store.count == 0);
+    CHECK(store.worldMatrices.empty() && store.denseToSlot.empty());
+}
+
+//--Job system--
+static void TestParallelFor()
+{
+    const u32 workerCounts[] = { 0, 1, 3 };
+    for (u32 workerCount : workerCounts)
+    {
+        JobSystem jobs;
+        CreateJobSystem(jobs, workerCount);
+
+        //Every index exactly once, whatever the range size
+        const u32 count = 10007;
+        const u32 rangeSizes[] = { 0, 1, 64, count, count * 2 };
+        for (u32 rangeSize : rangeSizes)
+        {
+            std::vector<std::atomic<u32>> visits(count);
+            ParallelFor(jobs, count, rangeSize, [&visits](u32 begin, u32 end)
+            {
+                for (u32 i = begin; i < end; ++i)
+                    visits[i].fetch_add(1);
+            });
+
+            bool visitedOnce = true;
+            for (u32 i = 0; i < count; ++i)
+                visitedOnce = visitedOnce && visits[i].load() == 1;
+            CHECK(visitedOnce);
+        }
+
+        //Jobs waiting on jobs they start
+        JobCounter outer;
+        std::atomic<u32> innerRuns{0};
+        for (u32 i = 0; i < 8; ++i)
+        {
+            RunJob(jobs, [&jobs, &innerRuns]
+            {
+                JobCounter inner;
+                for (u32 j = 0; j < 8; ++j)
+                    RunJob(jobs, [&innerRuns] { innerRuns.fetch_add(1); }, &inner);
+                WaitForCounter(jobs, inner);
+            }, &outer);
+        }
+        WaitForCounter(jobs, outer);
+        CHECK(innerRuns.load() == 64);
+        CHECK(outer.pending.load() == 0);
+
+        DestroyJobSystem(jobs);
+    }
+}
+
+static void TestWaitOnlyRunsItsCounter()
+{
+    //Without workers nothing but the waiting thread runs jobs. The caller of ParallelFor runs
+    //the first range itself before it waits, a job of another counter queued from there is
+    //the freshest one of its deque when the wait starts and must be left alone
+    JobSystem jobs;
+    CreateJobSystem(jobs, 0);
+
+    JobCounter background;
+    bool backgroundRan = false;
+    u32 sum = 0;
+    ParallelFor(jobs, 64, 1, [&](u32 begin, u32 end)
+    {
+        if (begin == 0)
+            RunJob(jobs, [&backgroundRan] { backgroundRan = true; }, &background);
+        for (u32 i = begin; i < end; ++i)
+            sum += i;
+    });
+    CHECK(sum == 64 * 63 / 2);
+    CHECK(!backgroundRan);
+
+    WaitForCounter(jobs, background);
+    CHECK(backgroundRan);
+
+    DestroyJobSystem(jobs);
+}
+
+//--Mesh cache--
+static void TestMeshCacheValidation()
+{
+    MeshCacheHeader header = {};
+    header.submeshCount = 2;
+    header.materialCount = 1;
+    header.vertexDataSize = 2 * 3 * 32;
+    header.indexDataSize = 2 * 3 * sizeof(u32);
+
+    MeshCacheSubmesh submeshes[2] = {};
+    for (u32 i = 0; i < 2; ++i)
+    {
+        submeshes[i].vertexOffset = i * 3 * 32;
+        submeshes[i].indexOffset = i * 3 * sizeof(u32);
+        submeshes[i].indexCount = 3;
+        submeshes[i].stride = 32;
+        submeshes[i].attributeCount = 3;
+    }
+    MeshCacheMaterial material = {};
+    strcpy(material.name, "material");
+    strcpy(material.textures[MeshCacheTexture_Albedo], "albedo.png");
+    CHECK(ValidateMeshCacheRecords(header, submeshes, &material));
+
+    //One broken field at a time
+    MeshCacheSubmesh broken[2];
+    auto isRejected = [&header, &submeshes, &broken, &material](void (*breakRecord)(MeshCacheSubmesh*))
+    {
+        memcpy(broken, submeshes, sizeof(broken));
+        breakRecord(broken);
+        return !ValidateMeshCacheRecords(header, broken, &material);
+    };
+    CHECK(isRejected([](MeshCacheSubmesh* s) { s[1].indexCount = 4; }));
+    CHECK(isRejected([](MeshCacheSubmesh* s) { s[1].indexOffset = 0xFFFFFFF0u; s[1].indexCount = 0x40000000u; }));
+    CHECK(isRejected([](MeshCacheSubmesh* s) { s[1].vertexOffset = 2 * 3 * 32 + 4; }));
+    CHECK(isRejected([](MeshCacheSubmesh* s) { s[0].vertexOffset = 3 * 32 + 4; }));
+    CHECK(isRejected([](MeshCacheSubmesh* s) { s[0].indexOffset = 4; }));
+    CHECK(isRejected([](MeshCacheSubmesh* s) { s[0].stride = 0; }));
+    CHECK(isRejected([](MeshCacheSubmesh* s) { s[0].attributeCount = MESH_CACHE_MAX_ATTRIBUTES + 1; }));
+    CHECK(isRejected([](MeshCacheSubmesh* s) { s[1].materialIdx = 1; }));
+
+    //Strings running past their array
+    MeshCacheMaterial unterminated = material;
+    memset(unterminated.name, 'a', MESH_CACHE_NAME_LENGTH);
+    CHECK(!ValidateMeshCacheRecords(header, submeshes, &unterminated));
+    unterminated = material;
+    memset(unterminated.textures[MeshCacheTexture_Bump], 'b', MESH_CACHE_PATH_LENGTH);
+    CHECK(!ValidateMeshCacheRecords(header, submeshes, &unterminated));
+}
+
+//--Block compression--
+static void DecodeRGB565(u16 packed, i32* color)
+{
+    i32 r = (packed >> 11) & 31, g = (packed >> 5) & 63, b = packed & 31;
+    color[0] = (r << 3) | (r >> 2);
+    color[1] = (g << 2) | (g >> 4);
+    color[2] = (b << 3) | (b >> 2);
+}
+
+static void DecodeBlockBC1(const u8* block, u8 rgb[48])
+{
+    u16 color0 = (u16)(block[0] | (block[1] << 8));
+    u16 color1 = (u16)(block[2] | (block[3] << 8));
+    i32 palette[4][3];
+    DecodeRGB565(color0, palette[0]);
+    DecodeRGB565(color1, palette[1]);
+    for (u32 c = 0; c < 3; ++c)
+    {
+        palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+        palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+    }
+    u32 indices = block[4] | (block[5] << 8) | (block[6] << 16) | ((u32)block[7] << 24);
+    for (u32 i = 0; i < 16; ++i)
+        for (u32 c = 0; c < 3; ++c)
+            rgb[i * 3 + c] = (u8)palette[(indices >> (2 * i)) & 3][c];
+}
+
+static void DecodeBlockBC4(const u8* block, u8 values[16])
+{
+    i32 palette[8] = { block[0], block[1] };
+    for (u32 i = 1; i < 7; ++i)
+        palette[i + 1] = block[0] > block[1] ? ((7 - i) * block[0] + i * block[1]) / 7 : 0;
+    u64 indices = 0;
+    for (u32 b = 0; b < 6; ++b)
+        indices |= (u64)block[2 + b] << (8 * b);
+    for (u32 i = 0; i < 16; ++i)
+        values[i] = (u8)palette[(indices >> (3 * i)) & 7];
+}
+
+static void TestBC1()
+{
+    //A gradient along one axis is what the four color mode represents best
+    u8 rgba[64];
+    for (u32 i = 0; i < 16; ++i)
+    {
+        rgba[i * 4 + 0] = (u8)(40 + i * 12);
+        rgba[i * 4 + 1] = (u8)(200 - i * 8);
+        rgba[i * 4 + 2] = (u8)(16 + i * 4);
+        rgba[i * 4 + 3] = 255;
+    }
+    u8 block[8];
+    EncodeBlockBC1(rgba, block);
+    CHECK((block[0] | (block[1] << 8)) > (block[2] | (block[3] << 8))); //Four color mode
+
+    u8 rgb[48];
+    DecodeBlockBC1(block, rgb);
+    i32 maxError = 0;
+    for (u32 i = 0; i < 16; ++i)
+        for (u32 c = 0; c < 3; ++c)
+            maxError = std::max(maxError, abs(rgb[i * 3 + c] - rgba[i * 4 + c]));
+    CHECK(maxError <= 32);
+
+    //A flat block decodes to its color, up to the 565 quantization
+    for (u32 i = 0; i < 16; ++i)
+    {
+        rgba[i * 4 + 0] = 128;
+        rgba[i * 4 + 1] = 64;
+        rgba[i * 4 + 2] = 200;
+    }
+    EncodeBlockBC1(rgba, block);
+    DecodeBlockBC1(block, rgb);
+    bool isFlat = true;
+    for (u32 i = 0; i < 16; ++i)
+        isFlat = isFlat && abs(rgb[i * 3 + 0] - 128) <= 4 && abs(rgb[i * 3 + 1] - 64) <= 2 && abs(rgb[i * 3 + 2] - 200) <= 4;
+    CHECK(isFlat);
+}
+
+static void TestBC4()
+{
+    u8 values[16];
+    for (u32 i = 0; i < 16; ++i)
+        values[i] = (u8)(30 + i * 13);
+    u8 block[8];
+    EncodeBlockBC4(values, block);
+    CHECK(block[0] == 30 + 15 * 13 && block[1] == 30);
+
+    //Eight steps over the range: no value is more than half a step away
+    u8 decoded[16];
+    DecodeBlockBC4(block, decoded);
+    i32 maxError = 0;
+    for (u32 i = 0; i < 16; ++i)
+        maxError = std::max(maxError, abs(decoded[i] - values[i]));
+    CHECK(maxError <= (15 * 13) / 14 + 1);
+
+    memset(values, 77, sizeof(values));
+    EncodeBlockBC4(values, block);
+    DecodeBlockBC4(block, decoded);
+    bool isFlat = true;
+    for (u32 i = 0; i < 16; ++i)
+        isFlat = isFlat && decoded[i] == 77;
+    CHECK(isFlat);
+}
+
+//--Benchmark results--
+static void TestPercentiles()
+{
+    std::vector<f32> samples;
+    for (u32 i = 100; i >= 1; --i)
+        samples.push_back((f32)i);
+
+    BenchmarkPercentiles percentiles = ComputePercentiles(samples);
+    CHECK(percentiles.min == 1.0f);
+    CHECK(percentiles.max == 100.0f);
+    CHECK(percentiles.average == 50.5f);
+    CHECK(percentiles.p50 == 50.0f);
+    CHECK(percentiles.p90 == 90.0f);
+    CHECK(percentiles.p95 == 95.0f);
+    CHECK(percentiles.p99 == 99.0f);
+
+    BenchmarkPercentiles single = ComputePercentiles(std::vector<f32>(1, 3.0f));
+    CHECK(single.min == 3.0f && single.p50 == 3.0f && single.p99 == 3.0f && single.max == 3.0f);
+
+    BenchmarkPercentiles empty = ComputePercentiles(std::vector<f32>());
+    CHECK(empty.max == 0.0f && empty.average == 0.0f);
+}
+
+static BenchmarkSamples ScaleSamples(const BenchmarkSamples& samples, f32 scale)
+{
+    BenchmarkSamples scaled = samples;
+    for (f32& sample : scaled.cpuMilliseconds) sample *= scale;
+    for (f32& sample : scaled.frameMilliseconds) sample *= scale;
+    for (f32& sample : scaled.gpuFrameMilliseconds) sample *= scale;
+    return scaled;
+}
+
+static void TestBenchmarkRegressions()
+{
+    BenchmarkSamples samples;
+    for (u32 i = 0; i < 200; ++i)
+    {
+        samples.cpuMilliseconds.push_back(4.0f + (i % 10) * 0.1f);
+        samples.frameMilliseconds.push_back(16.0f + (i % 7) * 0.2f);
+        samples.gpuFrameMilliseconds.push_back(8.0f + (i % 5) * 0.3f);
+    }
+
+    const char* baselinePath = "engine_tests_baseline.json";
+    BenchmarkOptions options;
+    CHECK(WriteBenchmarkJson(baselinePath, options, 200, samples));
+
+    CHECK(CheckBenchmarkRegressions(samples, baselinePath, 0.1f) == 0);
+    CHECK(CheckBenchmarkRegressions(ScaleSamples(samples, 1.05f), baselinePath, 0.1f) == 0);
+    CHECK(CheckBenchmarkRegressions(ScaleSamples(samples, 0.5f), baselinePath, 0.1f) == 0);
+    //p50, p95 and p99 of the three compared metrics
+    CHECK(CheckBenchmarkRegressions(ScaleSamples(samples, 1.5f), baselinePath, 0.1f) == 9);
+
+    //Only the metric that grew
+    BenchmarkSamples slowerCpu = samples;
+    for (f32& sample : slowerCpu.cpuMilliseconds)
+        sample *= 2.0f;
+    CHECK(CheckBenchmarkRegressions(slowerCpu, baselinePath, 0.1f) == 3);
+
+    //Metrics without samples are not compared
+    BenchmarkSamples noGpu = ScaleSamples(samples, 1.5f);
+    noGpu.gpuFrameMilliseconds.clear();
+    CHECK(CheckBenchmarkRegressions(noGpu, baselinePath, 0.1f) == 6);
+
+    CHECK(CheckBenchmarkRegressions(samples, "engine_tests_missing.json", 0.1f) == -1);
+    remove(baselinePath);
+}
+
+//--Scene descriptions--
+static void TestSceneParser()
+{
+    const char* scenePath = "engine_tests.scene";
+    CHECK(WriteTextFile(scenePath,
+        "# A comment line\n"
+        "model dice Dice/dice.obj\n"
+        "\n"
+        "entity dice 1 2 3 rotate 0 90 0 scale 2 variant 3   # trailing comment\n"
+        "entity patrick -1 0 0.5 scale 1 2 3 texture Patrick/skin.png\n"
+        "light point 0 5 0 diffuse 1 0.5 0.25 constant 2\n"
+        "light directional 0 -1 0\n"
+        "camera 2 0 1 10 -90 -5\n"
+        "camera 0 0 1 5 -90 0\n"
+        "camera 1 1 1 5 -80 0\n"));
+
+    SceneDescription scene;
+    CHECK(ParseSceneDescription(scenePath, scene));
+    CHECK(scene.models.size() == 1 && scene.models[0].name == "dice" && scene.models[0].path == "Dice/dice.obj");
+
+    CHECK(scene.entities.size() == 2);
+    if (scene.entities.size() == 2)
+    {
+        const SceneEntity& dice = scene.entities[0];
+        CHECK(dice.model == "dice" && dice.position == glm::vec3(1.0f, 2.0f, 3.0f));
+        CHECK(dice.rotation == glm::vec3(0.0f, 90.0f, 0.0f) && dice.scale == glm::vec3(2.0f));
+        CHECK(dice.materialVariant == 3 && dice.albedoTexture.empty());
+
+        const SceneEntity& patrick = scene.entities[1];
+        CHECK(patrick.position == glm::vec3(-1.0f, 0.0f, 0.5f) && patrick.scale == glm::vec3(1.0f, 2.0f, 3.0f));
+        CHECK(patrick.albedoTexture == "Patrick/skin.png");
+    }
+
+    CHECK(scene.lights.size() == 2);
+    if (scene.lights.size() == 2)
+    {
+        CHECK(!scene.lights[0].isDirectional && scene.lights[0].vector == glm::vec3(0.0f, 5.0f, 0.0f));
+        CHECK(scene.lights[0].diffuse == glm::vec3(1.0f, 0.5f, 0.25f) && scene.lights[0].constant == 2.0f);
+        CHECK(scene.lights[1].isDirectional);
+    }
+
+    //Keys are sorted by time
+    CHECK(scene.cameraPath.size() == 3);
+    if (scene.cameraPath.size() == 3)
+    {
+        CHECK(scene.cameraPath[0].time == 0.0f && scene.cameraPath[1].time == 1.0f && scene.cameraPath[2].time == 2.0f);
+        CHECK(scene.cameraPath[2].position == glm::vec3(0.0f, 1.0f, 10.0f) && scene.cameraPath[2].pitch == -5.0f);
+    }
+
+    //Any malformed directive fails the whole file
+    const char* invalidScenes[] = {
+        "entity dice 1 2\n",
+        "entity dice 1 2 3 scale 1 2\n",
+        "entity dice 1 2 3 spin 4\n",
+        "light spot 0 0 0\n",
+        "light point 0 0 0 diffuse 1\n",
+        "camera 0 1 2\n",
+        "teleport 1 2 3\n",
+        "stress instances=-3\n",
+    };
+    for (const char* text : invalidScenes)
+    {
+        SceneDescription invalid;
+        CHECK(WriteTextFile(scenePath, text));
+        CHECK(!ParseSceneDescription(scenePath, invalid));
+    }
+    remove(scenePath);
+
+    SceneDescription missing;
+    CHECK(!ParseSceneDescription("engine_tests_missing.scene", missing));
+}
+
+static void TestStressScenes()
+{
+    StressSceneOptions options;
+    CHECK(ParseStressSceneOptions("instances=12,lights=3,materials=4,layout=random,seed=9,spacing=2.5", options));
+    CHECK(options.instanceCount == 12 && options.pointLightCount == 3 && options.materialCount == 4);
+    CHECK(options.layout == StressLayout_Random && options.seed == 9 && options.spacing == 2.5f);
+
+    StressSceneOptions invalid;
+    CHECK(!ParseStressSceneOptions("instances=", invalid));
+    CHECK(!ParseStressSceneOptions("materials=0", invalid));
+    CHECK(!ParseStressSceneOptions("layout=spiral", invalid));
+    CHECK(!ParseStressSceneOptions("colors=3", invalid));
+
+    //Same options, same scene
+    SceneDescription first, second;
+    GenerateStressScene(options, first);
+    GenerateStressScene(options, second);
+    CHECK(first.entities.size() == second.entities.size() && first.entities.size() >= options.instanceCount);
+    bool isSame = first.entities.size() == second.entities.size();
+    for (u32 i = 0; isSame && i < first.entities.size(); ++i)
+        isSame = first.entities[i].position == second.entities[i].position && first.entities[i].materialVariant == second.entities[i].materialVariant;
+    CHECK(isSame);
+    CHECK(!first.cameraPath.empty());
+}
+
+static void TestCameraPath()
+{
+    std::vector<CameraKey> path(3);
+    path[0].time = 0.0f; path[0].position = glm::vec3(0.0f); path[0].yaw = -90.0f;
+    path[1].time = 2.0f; path[1].position = glm::vec3(4.0f, 0.0f, 0.0f); path[1].yaw = 0.0f;
+    path[2].time = 3.0f; path[2].position = glm::vec3(4.0f, 2.0f, 0.0f); path[2].pitch = 30.0f;
+    CHECK(GetCameraPathDuration(path) == 3.0f);
+
+    //Through every key, clamped at the ends
+    for (const CameraKey& key : path)
+    {
+        CameraKey sample = SampleCameraPath(path, key.time);
+        CHECK(glm::length(sample.position - key.position) < 1e-4f && fabsf(sample.yaw - key.yaw) < 1e-4f);
+    }
+    CHECK(SampleCameraPath(path, -1.0f).position == path[0].position);
+    CHECK(SampleCameraPath(path, 10.0f).position == path[2].position);
+    CHECK(SampleCameraPath(path, 10.0f).pitch == 30.0f);
+
+    //The ends repeat their key, so two keys are joined by a curve symmetric around its middle
+    std::vector<CameraKey> segment(path.begin(), path.begin() + 2);
+    CameraKey middle = SampleCameraPath(segment, 1.0f);
+    CHECK(glm::length(middle.position - glm::vec3(2.0f, 0.0f, 0.0f)) < 1e-4f);
+    CHECK(fabsf(middle.yaw + 45.0f) < 1e-4f);
+
+    //Continuous across a key
+    CameraKey before = SampleCameraPath(path, 2.0f - 1e-3f);
+    CameraKey after = SampleCameraPath(path, 2.0f + 1e-3f);
+    CHECK(glm::length(before.position - after.position) < 0.05f);
+
+    CHECK(GetCameraPathDuration(std::vector<CameraKey>(1)) == 0.0f);
+    CHECK(SampleCameraPath(std::vector<CameraKey>(), 1.0f).time == 0.0f);
+}
+
+//--Culling--
+static bool IsOutsideReference(const glm::vec3& center, const glm::vec3& extent, const glm::vec4* planes, f32& closestMargin)
+{
+    bool isOutside = false;
+    closestMargin = FLT_MAX;
+    for (u32 p = 0; p < 6; ++p)
+    {
+        const glm::vec4& plane = planes[p];
+        f32 distance = glm::dot(glm::vec3(plane), center) + plane.w;
+        f32 radius = glm::dot(glm::abs(glm::vec3(plane)), extent);
+        closestMargin = std::min(closestMargin, fabsf(distance + radius));
+        isOutside = isOutside || distance + radius < 0.0f;
+    }
+    return isOutside;
+}
+
+static void TestFrustumCulling()
+{
+    glm::mat4 projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 100.0f);
+    glm::mat4 view = glm::lookAt(glm::vec3(3.0f, 2.0f, 10.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    glm::vec4 planes[6];
+    ExtractFrustumPlanes(projection * view, planes);
+
+    //Random boxes around the frustum, padded like UpdateCullingBounds pads them
+    std::mt19937 random(3);
+    std::uniform_real_distribution<f32> position(-60.0f, 60.0f);
+    std::uniform_real_distribution<f32> size(0.0f, 4.0f);
+    CullingBounds bounds;
+    bounds.count = 1001;
+    for (u32 i = 0; i < bounds.count; ++i)
+    {
+        bounds.centerX.push_back(position(random));
+        bounds.centerY.push_back(position(random));
+        bounds.centerZ.push_back(position(random));
+        bounds.extentX.push_back(size(random));
+        bounds.extentY.push_back(size(random));
+        bounds.extentZ.push_back(size(random));
+    }
+    u32 paddedCount = (bounds.count + 3u) & ~3u;
+    bounds.centerX.resize(paddedCount, 0.0f);
+    bounds.centerY.resize(paddedCount, 0.0f);
+    bounds.centerZ.resize(paddedCount, 0.0f);
+    bounds.extentX.resize(paddedCount, 0.0f);
+    bounds.extentY.resize(paddedCount, 0.0f);
+    bounds.extentZ.resize(paddedCount, 0.0f);
+    bounds.isVisible.resize(paddedCount, 0);
+
+    TestBoundsAgainstFrustum(bounds, planes);
+
+    //Same answer as the scalar test, but for boxes touching a plane within rounding
+    u32 mismatches = 0, visibleCount = 0;
+    for (u32 i = 0; i < bounds.count; ++i)
+    {
+        glm::vec3 center(bounds.centerX[i], bounds.centerY[i], bounds.centerZ[i]);
+        glm::vec3 extent(bounds.extentX[i], bounds.extentY[i], bounds.extentZ[i]);
+        f32 closestMargin = 0.0f;
+        bool isVisible = !IsOutsideReference(center, extent, planes, closestMargin);
+        if (isVisible != (bounds.isVisible[i] != 0) && closestMargin > 1e-3f)
+            ++mismatches;
+        visibleCount += isVisible;
+    }
+    CHECK(mismatches == 0);
+    CHECK(visibleCount > 0 && visibleCount < bounds.count);
+
+    //Boxes with a known answer: the target, one behind the camera and one past the far plane
+    CullingBounds known;
+    known.count = 3;
+    known.centerX = { 0.0f, 6.0f, -60.0f, 0.0f };
+    known.centerY = { 0.0f, 4.0f, -40.0f, 0.0f };
+    known.centerZ = { 0.0f, 20.0f, -200.0f, 0.0f };
+    known.extentX = { 1.0f, 0.5f, 1.0f, 0.0f };
+    known.extentY = { 1.0f, 0.5f, 1.0f, 0.0f };
+    known.extentZ = { 1.0f, 0.5f, 1.0f, 0.0f };
+    known.isVisible.resize(4, 0);
+    TestBoundsAgainstFrustum(known, planes);
+    CHECK(known.isVisible[0] && !known.isVisible[1] && !known.isVisible[2]);
+
+    //An AABB rotated by 90 degrees around Y swaps its X and Z extents
+    AABB box;
+    box.min = glm::vec3(-1.0f, -2.0f, -3.0f);
+    box.max = glm::vec3(1.0f, 2.0f, 3.0f);
+    AABB rotated = TransformAABB(box, glm::translate(glm::vec3(5.0f, 0.0f, 0.0f)) * glm::rotate(glm::radians(90.0f), glm::vec3(0.0f, 1.0f, 0.0f)));
+    CHECK(glm::length(rotated.min - glm::vec3(2.0f, -2.0f, -1.0f)) < 1e-4f);
+    CHECK(glm::length(rotated.max - glm::vec3(8.0f, 2.0f, 1.0f)) < 1e-4f);
+}
+
+struct EngineTest
+{
+    const char* name;
+    void (*function)();
+};
+
+static const EngineTest s_tests[] = {
+    { "sort_keys", TestSortKeys },
+    { "radix_sort", TestRadixSort },
+    { "entity_handles", TestEntityHandles },
+    { "parallel_for", TestParallelFor },
+    { "wait_only_runs_its_counter", TestWaitOnlyRunsItsCounter },
+    { "mesh_cache_validation", TestMeshCacheValidation },
+    { "bc1", TestBC1 },
+    { "bc4", TestBC4 },
+    { "percentiles", TestPercentiles },
+    { "benchmark_regressions", TestBenchmarkRegressions },
+    { "scene_parser", TestSceneParser },
+    { "stress_scenes", TestStressScenes },
+    { "camera_path", TestCameraPath },
+    { "frustum_culling", TestFrustumCulling },
+};
+
+int main(int argc, char** argv)
+{
+    const char* filter = argc > 1 ? argv[1] : NULL;
+
+    u32 failedTests = 0, runTests = 0;
+    for (const EngineTest& test : s_tests)
+    {
+        if (filter && !strstr(test.name, filter))
+            continue;
+
+        u32 failedChecks = s_failedChecks;
+        test.function();
+        bool passed = s_failedChecks == failedChecks;
+        printf("%-28s %s\n", test.name, passed ? "passed" : "FAILED");
+        failedTests += !passed;
+        ++runTests;
+    }
+
+    printf("%u/%u tests passed\n", runTests - failedTests, runTests);
+    return failedTests == 0 && runTests > 0 ? 0 : 1;
+}
@@ -0,0 +1,220 @@
+#include "bc_encoder.h"
+#include "texture_baking.h"
+#include <float.h>
+#include <stdint.h>
+#include <string.h>
+
+//--Color helpers--
+static u16 PackRGB565(const u8* color)
+{
+    u32 r = (color[0] * 31 + 127) / 255;
+    u32 g = (color[1] * 63 + 127) / 255;
+    u32 b = (color[2] * 31 + 127) / 255;
+    return (u16)((r << 11) | (g << 5) | b);
+}
+
+static void UnpackRGB565(u16 packed, i32* color)
+{
+    i32 r = (packed >> 11) & 31;
+    i32 g = (packed >> 5) & 63;
+    i32 b = packed & 31;
+    color[0] = (r << 3) | (r >> 2);
+    color[1] = (g << 2) | (g >> 4);
+    color[2] = (b << 3) | (b >> 2);
+}
+
+static void WriteU16(u8* output, u16 value)
+{
+    output[0] = (u8)(value & 0xFF);
+    output[1] = (u8)(value >> 8);
+}
+
+//Principal axis of the block colors through a few power iterations of their covariance
+static void ComputeColorAxis(const u8 rgba[64], f32* axis)
+{
+    f32 mean[3] = {};
+    for (u32 i = 0; i < 16; ++i)
+        for (u32 c = 0; c < 3; ++c)
+            mean[c] += rgba[i * 4 + c];
+    for (u32 c = 0; c < 3; ++c)
+        mean[c] /= 16.0f;
+
+    f32 covariance[3][3] = {};
+    for (u32 i = 0; i < 16; ++i)
+    {
+        f32 d[3] = { rgba[i * 4 + 0] - mean[0], rgba[i * 4 + 1] - mean[1], rgba[i * 4 + 2] - mean[2] };
+        for (u32 row = 0; row < 3; ++row)
+            for (u32 col = 0; col < 3; ++col)
+                covariance[row][col] += d[row] * d[col];
+    }
+
+    axis[0] = axis[1] = axis[2] = 1.0f;
+    for (u32 iteration = 0; iteration < 8; ++iteration)
+    {
+        f32 next[3];
+        for (u32 row = 0; row < 3; ++row)
+            next[row] = covariance[row][0] * axis[0] + covariance[row][1] * axis[1] + covariance[row][2] * axis[2];
+
+        f32 largest = fmaxf(fabsf(next[0]), fmaxf(fabsf(next[1]), fabsf(next[2])));
+        if (largest <= 0.0f)
+            return; //Flat block, any axis will do
+
+        for (u32 c = 0; c < 3; ++c)
+            axis[c] = next[c] / largest;
+    }
+}
+
+//--BC1--
+void EncodeBlockBC1(const u8 rgba[64], u8* output)
+{
+    f32 axis[3];
+    ComputeColorAxis(rgba, axis);
+
+    u32 minIdx = 0, maxIdx = 0;
+    f32 minProjection = FLT_MAX, maxProjection = -FLT_MAX;
+    for (u32 i = 0; i < 16; ++i)
+    {
+        const u8* color = rgba + i * 4;
+        f32 projection = color[0] * axis[0] + color[1] * axis[1] + color[2] * axis[2];
+        if (projection < minProjection) { minProjection = projection; minIdx = i; }
+        if (projection > maxProjection) { maxProjection = projection; maxIdx = i; }
+    }
+
+    u16 color0 = PackRGB565(rgba + maxIdx * 4);
+    u16 color1 = PackRGB565(rgba + minIdx * 4);
+
+    //color0 > color1 selects the four color mode, equal endpoints only need index 0
+    if (color0 < color1)
+    {
+        u16 temp = color0;
+        color0 = color1;
+        color1 = temp;
+    }
+
+    WriteU16(output + 0, color0);
+    WriteU16(output + 2, color1);
+
+    u32 indices = 0;
+    if (color0 != color1)
+    {
+        i32 palette[4][3];
+        UnpackRGB565(color0, palette[0]);
+        UnpackRGB565(color1, palette[1]);
+        for (u32 c = 0; c < 3; ++c)
+        {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        }
+
+        for (u32 i = 0; i < 16; ++i)
+        {
+            const u8* color = rgba + i * 4;
+            u32 bestIndex = 0;
+            i32 bestDistance = INT32_MAX;
+            for (u32 p = 0; p < 4; ++p)
+            {
+                i32 dr = color[0] - palette[p][0];
+                i32 dg = color[1] - palette[p][1];
+                i32 db = color[2] - palette[p][2];
+                i32 distance = dr * dr + dg * dg + db * db;
+                if (distance < bestDistance)
+                {
+                    bestDistance = distance;
+                    bestIndex = p;
+                }
+            }
+            indices |= bestIndex << (2 * i);
+        }
+    }
+
+    for (u32 b = 0; b < 4; ++b)
+        output[4 + b] = (u8)(indices >> (8 * b));
+}
+
+//--BC4--
+void EncodeBlockBC4(const u8 values[16], u8* output)
+{
+    u8 minValue = 255, maxValue = 0;
+    for (u32 i = 0; i < 16; ++i)
+    {
+        if (values[i] < minValue) minValue = values[i];
+        if (values[i] > maxValue) maxValue = values[i];
+    }
+
+    //endpoint0 > endpoint1 selects the eight value mode
+    output[0] = maxValue;
+    output[1] = minValue;
+
+    u64 indices = 0;
+    if (maxValue > minValue)
+    {
+        i32 range = maxValue - minValue;
+        for (u32 i = 0; i < 16; ++i)
+        {
+            //Step 0 is endpoint0, step 7 is endpoint1, codes 2..7 are the interpolated steps 1..6
+            i32 step = ((maxValue - values[i]) * 7 + range / 2) / range;
+            u64 code = step == 0 ? 0 : (step == 7 ? 1 : step + 1);
+            indices |= code << (3 * i);
+        }
+    }
+
+    for (u32 b = 0; b < 6; ++b)
+        output[2 + b] = (u8)(indices >> (8 * b));
+}
+
+//--BC3 & BC5--
+static void ExtractChannel(const u8 rgba[64], u32 channel, u8* values)
+{
+    for (u32 i = 0; i < 16; ++i)
+        values[i] = rgba[i * 4 + channel];
+}
+
+void EncodeBlockBC3(const u8 rgba[64], u8* output)
+{
+    u8 alpha[16];
+    ExtractChannel(rgba, 3, alpha);
+    EncodeBlockBC4(alpha, output);
+    EncodeBlockBC1(rgba, output + 8);
+}
+
+void EncodeBlockBC5(const u8 rgba[64], u8* output)
+{
+    u8 values[16];
+    ExtractChannel(rgba, 0, values);
+    EncodeBlockBC4(values, output);
+    ExtractChannel(rgba, 1, values);
+    EncodeBlockBC4(values, output + 8);
+}
+
+//--Images--
+void EncodeImage(u32 format, const u8* rgba, u32 width, u32 height, u8* output)
+{
+    const u32 blockSize = GetBakedTextureBlockSize(format);
+    u8 block[64];
+
+    for (u32 blockY = 0; blockY < height; blockY += 4)
+    {
+        for (u32 blockX = 0; blockX < width; blockX += 4)
+        {
+            for (u32 y = 0; y < 4; ++y)
+            {
+                u32 sourceY = blockY + y < height ? blockY + y : height - 1;
+                for (u32 x = 0; x < 4; ++x)
+                {
+                    u32 sourceX = blockX + x < width ? blockX + x : width - 1;
+                    memcpy(block + (y * 4 + x) * 4, rgba + (sourceY * width + sourceX) * 4, 4);
+                }
+            }
+
+            switch (format)
+            {
+                case BakedTexture_BC1: EncodeBlockBC1(block, output); break;
+                case BakedTexture_BC3: EncodeBlockBC3(block, output); break;
+                case BakedTexture_BC4: { u8 red[16]; ExtractChannel(block, 0, red); EncodeBlockBC4(red, output); } break;
+                case BakedTexture_BC5: EncodeBlockBC5(block, output); break;
+                default: ASSERT(false, "Unknown baked texture format");
+            }
+            output += blockSize;
+        }
+    }
+}
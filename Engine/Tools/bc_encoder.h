@@ -0,0 +1,34 @@
+#pragma once
+
+#include "platform.h"
+
+//Block compression encoders used by the texture baker. Every function compresses one 4x4
+//block: pixels are given in row-major order (16 entries), RGBA8 unless stated otherwise.
+//Quality is that of a fast offline encoder: endpoints come from the principal axis of the
+//block colors, indices from the nearest palette entry.
+
+/**
+ * BC1 (DXT1) in its opaque four color mode. Writes 8 bytes.
+ */
+void EncodeBlockBC1(const u8 rgba[64], u8* output);
+
+/**
+ * BC3 (DXT5): BC4 alpha block followed by a BC1 color block. Writes 16 bytes.
+ */
+void EncodeBlockBC3(const u8 rgba[64], u8* output);
+
+/**
+ * BC4 (RGTC1) of a single channel, values holds 16 bytes. Writes 8 bytes.
+ */
+void EncodeBlockBC4(const u8 values[16], u8* output);
+
+/**
+ * BC5 (RGTC2): two BC4 blocks, red then green. Writes 16 bytes.
+ */
+void EncodeBlockBC5(const u8 rgba[64], u8* output);
+
+/**
+ * Compresses a whole RGBA8 image, edge blocks repeat the last row/column.
+ * output must hold ceil(width/4) * ceil(height/4) blocks of the format.
+ */
+void EncodeImage(u32 format, const u8* rgba, u32 width, u32 height, u8* output);
@@ -0,0 +1,214 @@
+#include "texture_baking.h"
+#include "bc_encoder.h"
+#include <stb_image.h>
+#include <ctype.h>
+#include <string.h>
+#include <stdlib.h>
+
+//Offline texture baker: compresses images into block-compressed .btex containers with
+//their full mip chain, see texture_baking.h. Usage:
+//    texture_baker [--format bc1|bc3|bc4|bc5] image.png...
+//Without --format the format is picked per image: BC1 for normal maps (file name containing
+//"normal", their alpha is unused), BC4 for single channel images, BC3 if any pixel is
+//translucent, BC1 otherwise. BC5 keeps only x and y and no shader rebuilds z, so normal
+//maps only get it with --format bc5.
+
+static const char* FormatNames[BakedTexture_Count] = { "bc1", "bc3", "bc4", "bc5" };
+
+static u32 ParseFormat(const char* name)
+{
+    for (u32 format = 0; format < BakedTexture_Count; ++format)
+        if (strcmp(name, FormatNames[format]) == 0)
+            return format;
+    return BakedTexture_Count;
+}
+
+static bool IsNormalMap(const char* filepath)
+{
+    //The file name only, directories such as normals/ say nothing about the image
+    const char* filename = filepath;
+    for (const char* c = filepath; *c; ++c)
+        if (*c == '/' || *c == '\\')
+            filename = c + 1;
+
+    std::string lowercase = filename;
+    for (char& c : lowercase)
+        c = (char)tolower(c);
+    return lowercase.find("normal") != std::string::npos;
+}
+
+static u32 ChooseFormat(const char* filepath, const u8* rgba, u32 pixelCount, int channels)
+{
+    if (IsNormalMap(filepath))
+        return BakedTexture_BC1;
+    if (channels == 1)
+        return BakedTexture_BC4;
+
+    if (channels == 4 || channels == 2)
+        for (u32 i = 0; i < pixelCount; ++i)
+            if (rgba[i * 4 + 3] != 255)
+                return BakedTexture_BC3;
+
+    return BakedTexture_BC1;
+}
+
+//2x2 box filter, odd sizes repeat the last row/column
+static void DownsampleRGBA(const u8* source, u32 width, u32 height, u8* destination)
+{
+    u32 nextWidth = width > 1 ? width / 2 : 1;
+    u32 nextHeight = height > 1 ? height / 2 : 1;
+
+    for (u32 y = 0; y < nextHeight; ++y)
+    {
+        u32 y0 = y * 2;
+        u32 y1 = y0 + 1 < height ? y0 + 1 : y0;
+        for (u32 x = 0; x < nextWidth; ++x)
+        {
+            u32 x0 = x * 2;
+            u32 x1 = x0 + 1 < width ? x0 + 1 : x0;
+            for (u32 c = 0; c < 4; ++c)
+            {
+                u32 sum = source[(y0 * width + x0) * 4 + c] + source[(y0 * width + x1) * 4 + c] +
+                          source[(y1 * width + x0) * 4 + c] + source[(y1 * width + x1) * 4 + c];
+                destination[(y * nextWidth + x) * 4 + c] = (u8)((sum + 2) / 4);
+            }
+        }
+    }
+}
+
+static bool BakeTexture(const char* filepath, u32 forcedFormat)
+{
+    MappedFile source = MapFile(filepath);
+    if (!source.data)
+    {
+        ELOG("Could not open %s", filepath);
+        return false;
+    }
+    u64 sourceHash = HashBytes(source.data, source.size);
+    UnmapFile(source);
+
+    //Same orientation as LoadImage, so the baked mips upload like the decoded image
+    int width = 0, height = 0, channels = 0;
+    stbi_set_flip_vertically_on_load(true);
+    u8* pixels = stbi_load(filepath, &width, &height, &channels, 4);
+    if (!pixels)
+    {
+        ELOG("Could not decode %s: %s", filepath, stbi_failure_reason());
+        return false;
+    }
+
+    u32 format = forcedFormat < BakedTexture_Count ? forcedFormat : ChooseFormat(filepath, pixels, width * height, channels);
+    u32 blockSize = GetBakedTextureBlockSize(format);
+
+    //--Mip chain layout--
+    BakedTextureHeader header = {};
+    header.magic = BAKED_TEXTURE_MAGIC;
+    header.version = BAKED_TEXTURE_VERSION;
+    header.sourceHash = sourceHash;
+    header.format = format;
+    header.width = width;
+    header.height = height;
+
+    BakedTextureMip mips[BAKED_TEXTURE_MAX_MIPS] = {};
+    u32 offset = sizeof(BakedTextureHeader);
+    u32 mipWidth = width, mipHeight = height;
+    for (;;)
+    {
+        BakedTextureMip& mip = mips[header.mipCount++];
+        mip.width = mipWidth;
+        mip.height = mipHeight;
+        mip.size = ((mipWidth + 3) / 4) * ((mipHeight + 3) / 4) * blockSize;
+
+        if ((mipWidth == 1 && mipHeight == 1) || header.mipCount == BAKED_TEXTURE_MAX_MIPS)
+            break;
+        mipWidth = mipWidth > 1 ? mipWidth / 2 : 1;
+        mipHeight = mipHeight > 1 ? mipHeight / 2 : 1;
+    }
+
+    offset += header.mipCount * sizeof(BakedTextureMip);
+    for (u32 level = 0; level < header.mipCount; ++level)
+    {
+        mips[level].offset = offset;
+        offset += mips[level].size;
+    }
+
+    //--Encode every level straight into the output file--
+    //It is written aside and renamed over the old one, with the header last, so neither a bake
+    //interrupted halfway nor an engine loading the old file meanwhile sees a partial texture
+    std::string bakedPath = GetBakedTexturePath(filepath);
+    MappedFile output = CreateReplacementFile(bakedPath.c_str(), offset);
+    if (!output.data)
+    {
+        ELOG("Could not create %s", bakedPath.c_str());
+        stbi_image_free(pixels);
+        return false;
+    }
+
+    u8* outputData = (u8*)output.data;
+    memset(outputData, 0, sizeof(header));
+    memcpy(outputData + sizeof(header), mips, header.mipCount * sizeof(BakedTextureMip));
+
+    std::vector<u8> level(pixels, pixels + width * height * 4);
+    std::vector<u8> nextLevel;
+    stbi_image_free(pixels);
+
+    for (u32 i = 0; i < header.mipCount; ++i)
+    {
+        EncodeImage(format, level.data(), mips[i].width, mips[i].height, outputData + mips[i].offset);
+        if (i + 1 < header.mipCount)
+        {
+            nextLevel.resize(mips[i + 1].width * mips[i + 1].height * 4);
+            DownsampleRGBA(level.data(), mips[i].width, mips[i].height, nextLevel.data());
+            level.swap(nextLevel);
+        }
+    }
+
+    memcpy(outputData, &header, sizeof(header));
+    if (!CommitReplacementFile(output, bakedPath.c_str()))
+    {
+        ELOG("Could not replace %s", bakedPath.c_str());
+        return false;
+    }
+
+    //Compare with what CreateTexture2DFromImage keeps in VRAM: RGB8/RGBA8 plus a third for the mips
+    u64 uncompressedSize = (u64)width * height * (channels == 4 ? 4 : 3) * 4 / 3;
+    u64 compressedSize = offset - mips[0].offset;
+    ILOG("%s: %dx%d, %u mips, %s, %.1f KB -> %.1f KB (%.1fx)", bakedPath.c_str(), width, height, header.mipCount,
+        FormatNames[format], uncompressedSize / 1024.0, compressedSize / 1024.0, (f64)uncompressedSize / compressedSize);
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    u32 forcedFormat = BakedTexture_Count;
+    u32 failures = 0;
+    u32 baked = 0;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "--format") == 0 && i + 1 < argc)
+        {
+            forcedFormat = ParseFormat(argv[++i]);
+            if (forcedFormat == BakedTexture_Count)
+            {
+                ELOG("Unknown format %s, expected bc1, bc3, bc4 or bc5", argv[i]);
+                return 1;
+            }
+        }
+        else if (BakeTexture(argv[i], forcedFormat))
+        {
+            ++baked;
+        }
+        else
+        {
+            ++failures;
+        }
+    }
+
+    if (baked + failures == 0)
+    {
+        ELOG("Usage: texture_baker [--format bc1|bc3|bc4|bc5] image.png...");
+        return 1;
+    }
+    return failures == 0 ? 0 : 1;
+}
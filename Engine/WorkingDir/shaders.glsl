@@ -9,19 +9,32 @@
 layout(location=0) in vec3 aPosition;
 layout(location=1) in vec3 aNormal;
 layout(location=2) in vec2 aTexCoord;
+layout(location=7) in uint aInstanceIdx; //gl_InstanceID plus the draw's base instance
 
-layout(binding = 1, std140) uniform LocalParams
+struct Instance
 {
-	mat4 model;
+	vec4 modelRows[3]; //the last row is always (0, 0, 0, 1)
 	mat4 MVP;
+	uint materialIdx;
+};
+
+layout(binding = 1, std430) readonly buffer InstanceParams
+{
+	Instance uInstances[];
 };
 
 out vec2 vTexCoord;
 out vec3 vPosition; //in world space
 out vec3 vNormal; //in world space
+flat out uint vMaterialIdx;
 
 void main()
 {
+	Instance instance = uInstances[aInstanceIdx];
+	mat4 model = transpose(mat4(instance.modelRows[0], instance.modelRows[1], instance.modelRows[2], vec4(0.0, 0.0, 0.0, 1.0)));
+	mat4 MVP = instance.MVP;
+	vMaterialIdx = instance.materialIdx;
+
 	vTexCoord = aTexCoord;
 	vPosition = vec3(model * vec4(aPosition,1.0));
 	vNormal = mat3(transpose(inverse(model))) * aNormal;
@@ -39,15 +52,25 @@ layout (location = 3) out vec4 gSpec;
 in vec2 vTexCoord;
 in vec3 vPosition;
 in vec3 vNormal;
+flat in uint vMaterialIdx;
 
 struct Material
 {
 	sampler2D diffuse;
+};
+
+uniform Material material;
+
+struct MaterialParams
+{
 	vec3 specular;
 	float shininess;
 };
 
-uniform Material material;
+layout(binding = 2, std430) readonly buffer Materials
+{
+	MaterialParams uMaterials[];
+};
 
 float near = 0.1; 
 float far = 20.0; 
@@ -67,7 +90,7 @@ void main()
     // and the diffuse per-fragment color
     gAlbedo = texture(material.diffuse, vTexCoord);
     // store specular intensity in gAlbedoSpec's alpha component
-    gSpec = vec4(material.specular,1.0);
+    gSpec = vec4(uMaterials[vMaterialIdx].specular,1.0);
 
     float depth = LinearizeDepth(gl_FragCoord.z) / far;
     gl_FragDepth = depth;
@@ -82,7 +105,7 @@ void main()
 
 struct Light
 {
-	unsigned int type;
+	uint type;
 	vec3 position;
 	vec3 direction;
 	vec3 ambient;
@@ -94,8 +117,8 @@ struct Light
 layout(binding = 0,std140) uniform GlobalParams
 {
 	vec3 uCameraPosition;
-	unsigned int uLightCount;
-	Light uLight[16];
+	uint uLightCount;
+	Light uLight[128]; //MAX_LIGHTS
 };
 
 #if defined(VERTEX) ///////////////////////////////////////////////////
@@ -241,7 +264,7 @@ void main()
 
 struct Light
 {
-	unsigned int type;
+	uint type;
 	vec3 position;
 	vec3 direction;
 	vec3 ambient;
@@ -253,8 +276,8 @@ struct Light
 layout(binding = 0,std140) uniform GlobalParams
 {
 	vec3 uCameraPosition;
-	unsigned int uLightCount;
-	Light uLight[16];
+	uint uLightCount;
+	Light uLight[128]; //MAX_LIGHTS
 };
 
 #if defined(VERTEX) ///////////////////////////////////////////////////